@@ -0,0 +1,24 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "allocations_counter.h"
+
+namespace {
+std::atomic<std::size_t> allocations{0};
+} // anonymous namespace
+
+std::size_t allocations_count() noexcept {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+void *operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *res = std::malloc(size == 0 ? 1 : size))
+    return res;
+  throw std::bad_alloc{};
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+#include <benchmark/benchmark.h>
+
+// Number of global operator new calls made by all threads of the process
+std::size_t allocations_count() noexcept;
+
+/**
+ * Reports average number of allocations per benchmark iteration as the
+ * "allocs/op" counter.
+ */
+class allocations_counter {
+public:
+  explicit allocations_counter(benchmark::State &state)
+      : state_(state), start_(allocations_count()) {}
+
+  ~allocations_counter() {
+    state_.counters["allocs/op"] = benchmark::Counter(
+        static_cast<double>(allocations_count() - start_),
+        benchmark::Counter::kAvgIterations);
+  }
+
+private:
+  benchmark::State &state_;
+  std::size_t start_;
+};
@@ -0,0 +1,52 @@
+#include <cstddef>
+#include <future>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <portable_concurrency/future>
+#include <portable_concurrency/thread_pool>
+
+#include "allocations_counter.h"
+
+namespace {
+
+constexpr std::size_t batch_size = 1000;
+
+// Launches batch of trivial tasks and waits for all of them.
+void async_thread_pool(benchmark::State &state) {
+  pc::static_thread_pool pool{static_cast<std::size_t>(state.range(0))};
+  std::vector<pc::future<std::size_t>> futures;
+  futures.reserve(batch_size);
+  allocations_counter counter{state};
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < batch_size; ++i)
+      futures.push_back(pc::async(pool.executor(), [i] { return i; }));
+    for (auto &future : futures)
+      benchmark::DoNotOptimize(future.get());
+    futures.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK(async_thread_pool)
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+void std_async(benchmark::State &state) {
+  std::vector<std::future<std::size_t>> futures;
+  futures.reserve(batch_size);
+  allocations_counter counter{state};
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < batch_size; ++i)
+      futures.push_back(std::async(std::launch::async, [i] { return i; }));
+    for (auto &future : futures)
+      benchmark::DoNotOptimize(future.get());
+    futures.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK(std_async)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+} // anonymous namespace
@@ -0,0 +1,33 @@
+#include <future>
+
+#include <benchmark/benchmark.h>
+
+#include <portable_concurrency/future>
+
+#include "allocations_counter.h"
+
+namespace {
+
+// Creates shared state, sets the value and gets it back on the same thread.
+void promise_future_round_trip(benchmark::State &state) {
+  allocations_counter counter{state};
+  for (auto _ : state) {
+    auto p = pc::make_promise<int>();
+    p.first.set_value(42);
+    benchmark::DoNotOptimize(p.second.get());
+  }
+}
+BENCHMARK(promise_future_round_trip);
+
+void std_promise_future_round_trip(benchmark::State &state) {
+  allocations_counter counter{state};
+  for (auto _ : state) {
+    std::promise<int> promise;
+    std::future<int> future = promise.get_future();
+    promise.set_value(42);
+    benchmark::DoNotOptimize(future.get());
+  }
+}
+BENCHMARK(std_promise_future_round_trip);
+
+} // anonymous namespace
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <portable_concurrency/execution>
+#include <portable_concurrency/future>
+#include <portable_concurrency/thread_pool>
+
+#include "allocations_counter.h"
+
+namespace {
+
+// Attaches chain of state.range(0) continuations to the not yet ready future,
+// then fulfills the promise and waits for the end of the chain.
+template <typename Executor>
+void run_then_chain(benchmark::State &state, Executor exec) {
+  const auto depth = state.range(0);
+  allocations_counter counter{state};
+  for (auto _ : state) {
+    auto p = pc::make_promise<int>();
+    pc::future<int> future = std::move(p.second);
+    for (auto i = depth; i > 0; --i)
+      future = future.then(exec, [](pc::future<int> f) { return f.get() + 1; });
+    p.first.set_value(0);
+    benchmark::DoNotOptimize(future.get());
+  }
+  state.SetItemsProcessed(state.iterations() * depth);
+}
+
+void then_chain_inplace(benchmark::State &state) {
+  run_then_chain(state, pc::inplace_executor);
+}
+BENCHMARK(then_chain_inplace)->RangeMultiplier(10)->Range(1, 1000);
+
+// Chain of continuations attached to the already ready future where every
+// stage is executed immediately.
+void then_chain_on_ready_future(benchmark::State &state) {
+  const auto depth = state.range(0);
+  allocations_counter counter{state};
+  for (auto _ : state) {
+    pc::future<int> future = pc::make_ready_future(0);
+    for (auto i = depth; i > 0; --i)
+      future = future.then([](pc::future<int> f) { return f.get() + 1; });
+    benchmark::DoNotOptimize(future.get());
+  }
+  state.SetItemsProcessed(state.iterations() * depth);
+}
+BENCHMARK(then_chain_on_ready_future)->RangeMultiplier(10)->Range(1, 1000);
+
+// Continuations attached to the results of operations where 9 of 10 results
+// are already available (e.g. cache hits) and the rest are fulfilled later.
+void then_on_mostly_ready_futures(benchmark::State &state) {
+  const auto count = state.range(0);
+  std::vector<pc::promise<int>> promises;
+  std::vector<pc::future<int>> results;
+  results.reserve(static_cast<std::size_t>(count));
+  allocations_counter counter{state};
+  for (auto _ : state) {
+    for (auto i = count; i > 0; --i) {
+      pc::future<int> source;
+      if (i % 10 == 0) {
+        auto p = pc::make_promise<int>();
+        promises.push_back(std::move(p.first));
+        source = std::move(p.second);
+      } else {
+        source = pc::make_ready_future(static_cast<int>(i));
+      }
+      results.push_back(
+          source.then([](pc::future<int> f) { return f.get() + 1; }));
+    }
+    for (auto &promise : promises)
+      promise.set_value(0);
+    for (auto &result : results)
+      benchmark::DoNotOptimize(result.get());
+    promises.clear();
+    results.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(then_on_mostly_ready_futures)->RangeMultiplier(10)->Range(10, 1000);
+
+void then_chain_thread_pool(benchmark::State &state) {
+  static pc::static_thread_pool pool{
+      std::max(2u, std::thread::hardware_concurrency())};
+  run_then_chain(state, pool.executor());
+}
+BENCHMARK(then_chain_thread_pool)
+    ->RangeMultiplier(10)
+    ->Range(1, 1000)
+    ->UseRealTime();
+
+} // anonymous namespace
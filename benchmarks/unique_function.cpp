@@ -0,0 +1,72 @@
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include <benchmark/benchmark.h>
+
+#include <portable_concurrency/functional>
+
+#include "allocations_counter.h"
+
+namespace {
+
+// Constructs function with capture of the given size, moves it twice (as it
+// happens when the task is posted to the queue and taken from it) and calls.
+template <std::size_t CaptureSize, std::size_t BufferSize>
+void unique_function_by_capture_size(benchmark::State &state) {
+  std::array<char, CaptureSize> capture = {{1}};
+  allocations_counter counter{state};
+  for (auto _ : state) {
+    pc::basic_unique_function<char(), BufferSize> func =
+        [capture] { return capture[0]; };
+    auto queued = std::move(func);
+    auto taken = std::move(queued);
+    benchmark::DoNotOptimize(taken());
+  }
+}
+
+constexpr std::size_t default_buffer = pc::detail::small_buffer_size;
+
+BENCHMARK_TEMPLATE(unique_function_by_capture_size, 8, default_buffer);
+BENCHMARK_TEMPLATE(unique_function_by_capture_size, 32, default_buffer);
+BENCHMARK_TEMPLATE(unique_function_by_capture_size, 64, default_buffer);
+BENCHMARK_TEMPLATE(unique_function_by_capture_size, 128, default_buffer);
+BENCHMARK_TEMPLATE(unique_function_by_capture_size, 256, default_buffer);
+
+BENCHMARK_TEMPLATE(unique_function_by_capture_size, 8, 128);
+BENCHMARK_TEMPLATE(unique_function_by_capture_size, 32, 128);
+BENCHMARK_TEMPLATE(unique_function_by_capture_size, 64, 128);
+BENCHMARK_TEMPLATE(unique_function_by_capture_size, 128, 128);
+BENCHMARK_TEMPLATE(unique_function_by_capture_size, 256, 128);
+
+// Moves function through the queue of tasks. Trivially copyable callables are
+// relocated by copying the buffer bytes.
+template <typename F> void small_unique_function_move(benchmark::State &state) {
+  pc::detail::small_unique_function<int()> funcs[16];
+  for (auto &func : funcs)
+    func = F{};
+  for (auto _ : state) {
+    for (std::size_t i = 1; i < 16; ++i)
+      funcs[i - 1] = std::move(funcs[i]);
+    funcs[15] = std::move(funcs[0]);
+    benchmark::ClobberMemory();
+  }
+}
+
+struct trivial_callable {
+  int *ptr = nullptr;
+  int val = 42;
+  int operator()() const { return val; }
+};
+
+struct non_trivial_callable {
+  std::shared_ptr<int> ptr;
+  int val = 42;
+  int operator()() const { return val; }
+};
+
+BENCHMARK_TEMPLATE(small_unique_function_move, trivial_callable);
+BENCHMARK_TEMPLATE(small_unique_function_move, non_trivial_callable);
+
+} // anonymous namespace
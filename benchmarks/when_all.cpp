@@ -0,0 +1,60 @@
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <portable_concurrency/future>
+
+#include "allocations_counter.h"
+
+namespace {
+
+// Creates state.range(0) not yet ready futures, combines and fulfills all of
+// them.
+template <typename Combine>
+void run_combine(benchmark::State &state, Combine combine) {
+  const auto size = static_cast<std::size_t>(state.range(0));
+  std::vector<pc::promise<int>> promises;
+  std::vector<pc::future<int>> futures;
+  promises.reserve(size);
+  allocations_counter counter{state};
+  for (auto _ : state) {
+    // Vector is moved into the combined state on each iteration
+    futures.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+      auto p = pc::make_promise<int>();
+      promises.push_back(std::move(p.first));
+      futures.push_back(std::move(p.second));
+    }
+    auto combined = combine(std::move(futures));
+    for (auto &promise : promises)
+      promise.set_value(42);
+    benchmark::DoNotOptimize(combined.get());
+    promises.clear();
+    futures.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void when_all_vector(benchmark::State &state) {
+  run_combine(state, [](std::vector<pc::future<int>> futures) {
+    return pc::when_all(std::move(futures));
+  });
+}
+BENCHMARK(when_all_vector)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000000)
+    ->Unit(benchmark::kMicrosecond);
+
+void when_any_vector(benchmark::State &state) {
+  run_combine(state, [](std::vector<pc::future<int>> futures) {
+    return pc::when_any(std::move(futures));
+  });
+}
+BENCHMARK(when_any_vector)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000000)
+    ->Unit(benchmark::kMicrosecond);
+
+} // anonymous namespace
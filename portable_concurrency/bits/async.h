@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <tuple>
 #include <utility>
 
@@ -73,6 +74,37 @@ PC_NODISCARD auto async(E &&exec, F &&func, A &&...a) -> std::enable_if_t<
   return f;
 }
 
+/**
+ * @ingroup future_hdr
+ *
+ * Same as `async(exec, func, a...)` but the shared state of the returned future
+ * is allocated with the `allocator`. [EXTENSION]
+ *
+ * The function participates in overload resolution only if
+ * `is_executor<E>::value` is `true`.
+ */
+#if defined(DOXYGEN)
+template <typename Alloc, typename E, typename F, typename... A>
+future<std::result_of_t<F(A...)>> async(std::allocator_arg_t,
+                                        const Alloc &allocator, E &&exec,
+                                        F &&func, A &&...a) {
+#else
+template <typename Alloc, typename E, typename F, typename... A>
+PC_NODISCARD auto async(std::allocator_arg_t, const Alloc &allocator, E &&exec,
+                        F &&func, A &&...a)
+    -> std::enable_if_t<
+        is_executor<std::decay_t<E>>::value,
+        detail::add_future_t<detail::invoke_result_t<F, A...>>> {
+#endif
+  using R = detail::invoke_result_t<F, A...>;
+  packaged_task<R()> task{
+      std::allocator_arg, allocator,
+      detail::make_task(std::forward<F>(func), std::forward<A>(a)...)};
+  detail::add_future_t<R> f = task.get_future();
+  post(exec, std::move(task));
+  return f;
+}
+
 /**
  * @page unwrap Implicit unwrapping
  *
@@ -0,0 +1,63 @@
+#include <cassert>
+
+#include "barrier.h"
+#include "futex.h"
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+namespace detail {
+
+barrier_state::barrier_state(ptrdiff_t num_threads)
+    : remaining_{num_threads}, num_threads_{num_threads} {
+  assert(num_threads > 0);
+}
+
+barrier_state::~barrier_state() {
+  // Threads woken up by the barrier might still access it
+  for (auto n = waiters_.load(std::memory_order_acquire); n != 0;
+       n = waiters_.load(std::memory_order_acquire))
+    futex_wait(waiters_, n);
+}
+
+void barrier_state::arrive_and_wait(unique_function<ptrdiff_t()> *completion) {
+  waiters_.fetch_add(1, std::memory_order_relaxed);
+  // Phase number must be read before arrival since the phase might be
+  // completed by another thread right after it.
+  const auto phase = phase_.load(std::memory_order_acquire);
+  if (!arrive(completion)) {
+    while (phase_.load(std::memory_order_acquire) == phase)
+      futex_wait(phase_, phase);
+  }
+  if (waiters_.fetch_sub(1, std::memory_order_release) == 1)
+    futex_wake_all(waiters_);
+}
+
+void barrier_state::arrive_and_drop(unique_function<ptrdiff_t()> *completion) {
+  dropped_.fetch_add(1, std::memory_order_relaxed);
+  arrive(completion);
+}
+
+bool barrier_state::arrive(
+    unique_function<ptrdiff_t()> *completion) noexcept {
+  const ptrdiff_t prev = remaining_.fetch_sub(1, std::memory_order_acq_rel);
+  assert(prev > 0);
+  if (prev != 1)
+    return false;
+
+  // All of the threads participating in this phase have arrived so nobody else
+  // can touch the barrier until the phase number is changed.
+  num_threads_ -= dropped_.exchange(0, std::memory_order_relaxed);
+  if (completion && *completion) {
+    const ptrdiff_t next_num_threads = (*completion)();
+    if (next_num_threads != -1)
+      num_threads_ = next_num_threads;
+  }
+  remaining_.store(num_threads_, std::memory_order_relaxed);
+  phase_.fetch_add(1, std::memory_order_release);
+  futex_wake_all(phase_);
+  return true;
+}
+
+} // namespace detail
+} // namespace cxx14_v1
+} // namespace portable_concurrency
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "unique_function.hpp"
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+
+namespace detail {
+
+/**
+ * @internal
+ *
+ * Phase counter shared by `barrier` and `flex_barrier`. Arrivals decrement the
+ * atomic counter of the current phase and the last arriving thread starts the
+ * next phase by incrementing the phase number which is used as a futex word by
+ * the waiting threads.
+ */
+class barrier_state {
+public:
+  explicit barrier_state(ptrdiff_t num_threads);
+
+  barrier_state(const barrier_state &) = delete;
+  barrier_state &operator=(const barrier_state &) = delete;
+
+  ~barrier_state();
+
+  // Completion function is optional and might be null
+  void arrive_and_wait(unique_function<ptrdiff_t()> *completion);
+  void arrive_and_drop(unique_function<ptrdiff_t()> *completion);
+
+private:
+  // Returns true if the phase was completed by this call. Exception thrown by
+  // the completion function would leave the other threads blocked forever so
+  // it terminates the program same way as `std::barrier` does.
+  bool arrive(unique_function<ptrdiff_t()> *completion) noexcept;
+
+  std::atomic<std::uint32_t> phase_{0};
+  std::atomic<ptrdiff_t> remaining_;
+  std::atomic<ptrdiff_t> dropped_{0};
+  std::atomic<std::uint32_t> waiters_{0};
+  // Only accessed by the thread completing the phase
+  ptrdiff_t num_threads_;
+};
+
+} // namespace detail
+
+/**
+ * @headerfile portable_concurrency/barrier
+ * @ingroup barrier
+ *
+ * Reusable thread barrier. Each of the participating threads blocks in
+ * `arrive_and_wait` until all of the participating threads arrive at the
+ * barrier after which the barrier is reset for the next phase.
+ *
+ * Threads are only woken up when the last participating thread arrives. No
+ * locks are taken on arrival. Destructor blocks until all of the threads woken
+ * up by the barrier leave `arrive_and_wait`.
+ */
+class barrier {
+public:
+  /**
+   * Creates barrier for @a num_threads participating threads.
+   */
+  explicit barrier(ptrdiff_t num_threads) : state_{num_threads} {}
+
+  barrier(const barrier &) = delete;
+  barrier &operator=(const barrier &) = delete;
+
+  /**
+   * Arrives at the barrier and blocks until all of the participating threads
+   * arrive.
+   */
+  void arrive_and_wait() { state_.arrive_and_wait(nullptr); }
+
+  /**
+   * Arrives at the barrier without blocking and removes the calling thread from
+   * the set of the threads participating in the subsequent phases.
+   */
+  void arrive_and_drop() { state_.arrive_and_drop(nullptr); }
+
+private:
+  detail::barrier_state state_;
+};
+
+/**
+ * @headerfile portable_concurrency/barrier
+ * @ingroup barrier
+ *
+ * Reusable thread barrier with the completion function. Completion function is
+ * called by the last thread arriving at the barrier before any other thread is
+ * unblocked. It must return the number of threads participating in the next
+ * phase or -1 to keep the set of participating threads unchanged. If the
+ * completion function exits via exception `std::terminate` is called.
+ */
+class flex_barrier {
+public:
+  /**
+   * Creates barrier for @a num_threads participating threads without the
+   * completion function.
+   */
+  explicit flex_barrier(ptrdiff_t num_threads) : state_{num_threads} {}
+
+  /**
+   * Creates barrier for @a num_threads participating threads with the
+   * completion function @a completion. Function must be invocable with no
+   * arguments and return value convertible to `ptrdiff_t`.
+   */
+  template <typename F>
+  flex_barrier(ptrdiff_t num_threads, F &&completion)
+      : state_{num_threads}, completion_{std::forward<F>(completion)} {}
+
+  flex_barrier(const flex_barrier &) = delete;
+  flex_barrier &operator=(const flex_barrier &) = delete;
+
+  /**
+   * Arrives at the barrier and blocks until all of the participating threads
+   * arrive.
+   */
+  void arrive_and_wait() { state_.arrive_and_wait(&completion_); }
+
+  /**
+   * Arrives at the barrier without blocking and removes the calling thread from
+   * the set of the threads participating in the subsequent phases.
+   */
+  void arrive_and_drop() { state_.arrive_and_drop(&completion_); }
+
+private:
+  detail::barrier_state state_;
+  unique_function<ptrdiff_t()> completion_;
+};
+
+} // namespace cxx14_v1
+} // namespace portable_concurrency
@@ -0,0 +1,53 @@
+#pragma once
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+namespace detail {
+
+/**
+ * @internal
+ *
+ * Interface of the object notified when the current thread is about to block
+ * waiting for some future or latch to become ready. Thread pools install
+ * observer on their worker threads in order to compensate blocked workers.
+ */
+class blocking_observer {
+public:
+  virtual void blocking_started() noexcept = 0;
+  virtual void blocking_finished() noexcept = 0;
+
+protected:
+  ~blocking_observer() = default;
+};
+
+// Observer installed on the current thread or nullptr
+blocking_observer *&current_blocking_observer() noexcept;
+
+/**
+ * @internal
+ *
+ * Notifies blocking observer of the current thread about the blocking wait
+ * performed during the lifetime of this object.
+ */
+class blocking_region {
+public:
+  blocking_region() noexcept : observer_{current_blocking_observer()} {
+    if (observer_)
+      observer_->blocking_started();
+  }
+
+  ~blocking_region() {
+    if (observer_)
+      observer_->blocking_finished();
+  }
+
+  blocking_region(const blocking_region &) = delete;
+  blocking_region &operator=(const blocking_region &) = delete;
+
+private:
+  blocking_observer *observer_;
+};
+
+} // namespace detail
+} // namespace cxx14_v1
+} // namespace portable_concurrency
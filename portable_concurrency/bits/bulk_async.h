@@ -0,0 +1,196 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "concurrency_type_traits.h"
+#include "either.h"
+#include "execution.h"
+#include "future.h"
+#include "invoke.h"
+#include "shared_state.h"
+#include "unique_function.hpp"
+
+#include <portable_concurrency/bits/config.h>
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+
+namespace detail {
+
+template <typename R>
+using bulk_result_t =
+    std::conditional_t<std::is_void<R>::value, void, std::vector<R>>;
+
+template <typename R> class bulk_results {
+public:
+  explicit bulk_results(std::size_t count) : results_(count) {}
+
+  template <typename F> void run(F &func, std::size_t idx) {
+    results_[idx].emplace(in_place_index_t<1>{},
+                          ::portable_concurrency::cxx14_v1::detail::invoke(
+                              func, idx));
+  }
+
+  void set_value(shared_state<std::vector<R>> &state) {
+    std::vector<R> res;
+    res.reserve(results_.size());
+    for (auto &item : results_)
+      res.push_back(std::move(item.get(in_place_index_t<1>{})));
+    state.emplace(std::move(res));
+  }
+
+private:
+  std::vector<either<monostate, R>> results_;
+};
+
+template <> class bulk_results<void> {
+public:
+  explicit bulk_results(std::size_t) {}
+
+  template <typename F> void run(F &func, std::size_t idx) {
+    ::portable_concurrency::cxx14_v1::detail::invoke(func, idx);
+  }
+
+  void set_value(shared_state<void> &state) { state.emplace(); }
+};
+
+// Shared state of the future returned by bulk_async. Keeps itself alive until
+// all of the tasks are either executed or destroyed so tasks need neither
+// separate allocation nor reference counting. One extra completion is reserved
+// for the submitting thread.
+template <typename R, typename F>
+class bulk_state final : public shared_state<bulk_result_t<R>> {
+public:
+  bulk_state(std::size_t count, F &&func)
+      : func_(std::forward<F>(func)), results_(count), remaining_(count + 1) {}
+
+  static state_ptr<bulk_state> make(std::size_t count, F &&func) {
+    auto res = make_state<bulk_state>(count, std::forward<F>(func));
+    res->self_ = res;
+    return res;
+  }
+
+  void run(std::size_t idx) noexcept {
+    try {
+      results_.run(func_, idx);
+    } catch (...) {
+      set_error(std::current_exception());
+    }
+    complete();
+  }
+
+  void abandon_task() noexcept {
+    set_error(make_broken_promise());
+    complete();
+  }
+
+  void complete() noexcept {
+    if (remaining_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+      return;
+    const auto self = std::move(self_);
+    try {
+      if (error_)
+        this->set_exception(error_);
+      else
+        results_.set_value(*this);
+    } catch (...) {
+      this->set_exception(std::current_exception());
+    }
+  }
+
+private:
+  void set_error(std::exception_ptr error) noexcept {
+    if (!error_set_.test_and_set(std::memory_order_relaxed))
+      error_ = error;
+  }
+
+  std::decay_t<F> func_;
+  bulk_results<R> results_;
+  std::atomic<std::size_t> remaining_;
+  std::atomic_flag error_set_ = ATOMIC_FLAG_INIT;
+  std::exception_ptr error_;
+  state_ptr<bulk_state> self_;
+};
+
+template <typename R, typename F> class bulk_task {
+public:
+  bulk_task(bulk_state<R, F> *state, std::size_t idx) noexcept
+      : state_(state), idx_(idx) {}
+
+  bulk_task(bulk_task &&rhs) noexcept
+      : state_(std::exchange(rhs.state_, nullptr)), idx_(rhs.idx_) {}
+  bulk_task &operator=(bulk_task &&) = delete;
+
+  ~bulk_task() {
+    if (state_)
+      state_->abandon_task();
+  }
+
+  void operator()() { std::exchange(state_, nullptr)->run(idx_); }
+
+private:
+  bulk_state<R, F> *state_;
+  std::size_t idx_;
+};
+
+} // namespace detail
+
+/**
+ * @ingroup future_hdr
+ * @brief Runs `count` invocations of the function `func` asynchronously using
+ * executor `exec`.
+ *
+ * Function `func` is decay-copied once and then invoked as `func(i)` for each
+ * `i` from the range `[0, count)`. Invocations may run concurrently. Returns
+ * the future which becomes ready when all of the invocations are finished. It
+ * holds the vector of their results in the order of indexes or nothing if
+ * `func` returns void. If some of the invocations exit via exception the
+ * future holds one of those exceptions.
+ *
+ * All of the tasks share single allocated state and are submitted to the
+ * executor with single @ref post_bulk call.
+ *
+ * The function participates in overload resolution only if
+ * `is_executor<E>::value` is `true`.
+ */
+#if defined(DOXYGEN)
+template <typename E, typename F>
+future<std::vector<std::result_of_t<F(std::size_t)>>>
+bulk_async(E &&exec, std::size_t count, F &&func) {
+#else
+template <typename E, typename F>
+PC_NODISCARD auto bulk_async(E &&exec, std::size_t count, F &&func)
+    -> std::enable_if_t<
+        is_executor<std::decay_t<E>>::value,
+        future<detail::bulk_result_t<
+            detail::invoke_result_t<std::decay_t<F> &, std::size_t>>>> {
+#endif
+  using R = detail::invoke_result_t<std::decay_t<F> &, std::size_t>;
+  using state_t = detail::bulk_state<R, F>;
+  static_assert(!detail::is_future<R>::value,
+                "bulk_async does not support functions returning futures");
+
+  struct submission_guard {
+    ~submission_guard() { state->complete(); }
+    state_t *state;
+  };
+
+  std::vector<unique_function<void()>> tasks;
+  tasks.reserve(count);
+  auto state = state_t::make(count, std::forward<F>(func));
+  submission_guard guard{state.get()};
+  for (std::size_t i = 0; i < count; ++i)
+    tasks.emplace_back(detail::bulk_task<R, F>{state.get(), i});
+  future<detail::bulk_result_t<R>> res{std::move(state)};
+  post_bulk(exec, tasks.data(), tasks.data() + count);
+  return res;
+}
+
+} // namespace cxx14_v1
+} // namespace portable_concurrency
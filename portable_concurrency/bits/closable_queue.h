@@ -1,6 +1,7 @@
 #pragma once
 
 #include <condition_variable>
+#include <cstddef>
 #include <mutex>
 #include <queue>
 
@@ -11,13 +12,18 @@ namespace detail {
 template <typename T> class closable_queue {
 public:
   bool pop(T &dest);
+  bool try_pop(T &dest);
   void push(T &&val);
+  // Moves all of the values from the range [first, last) under single lock
+  void push(T *first, T *last);
   void close();
+  std::size_t size();
 
 private:
   std::mutex mutex_;
   std::condition_variable cv_;
   std::queue<T> queue_;
+  unsigned waiters_ = 0;
   bool closed_ = false;
 };
 
@@ -8,7 +8,9 @@ namespace detail {
 
 template <typename T> bool closable_queue<T>::pop(T &dest) {
   std::unique_lock<std::mutex> lock(mutex_);
+  ++waiters_;
   cv_.wait(lock, [this]() { return closed_ || !queue_.empty(); });
+  --waiters_;
   if (closed_ && queue_.empty())
     return false;
   std::swap(dest, queue_.front());
@@ -16,12 +18,37 @@ template <typename T> bool closable_queue<T>::pop(T &dest) {
   return true;
 }
 
+template <typename T> bool closable_queue<T>::try_pop(T &dest) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (queue_.empty())
+    return false;
+  std::swap(dest, queue_.front());
+  queue_.pop();
+  return true;
+}
+
 template <typename T> void closable_queue<T>::push(T &&val) {
   std::lock_guard<std::mutex> guard(mutex_);
   if (closed_)
     return;
   queue_.emplace(std::move(val));
-  cv_.notify_one();
+  if (waiters_ != 0)
+    cv_.notify_one();
+}
+
+template <typename T> void closable_queue<T>::push(T *first, T *last) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (closed_ || first == last)
+    return;
+  for (T *it = first; it != last; ++it)
+    queue_.emplace(std::move(*it));
+  if (waiters_ != 0)
+    cv_.notify_all();
+}
+
+template <typename T> std::size_t closable_queue<T>::size() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return queue_.size();
 }
 
 template <typename T> void closable_queue<T>::close() {
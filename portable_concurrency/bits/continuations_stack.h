@@ -1,10 +1,42 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
 #include "once_consumable_stack.h"
 #include "small_unique_function.hpp"
 
 namespace portable_concurrency {
 inline namespace cxx14_v1 {
+
+/**
+ * @headerfile portable_concurrency/future
+ * @ingroup future_hdr
+ *
+ * Sets the maximum nesting depth of the continuations executed inline on the
+ * thread which makes some shared state ready. Continuations of the state which
+ * becomes ready while @a depth levels of continuations are already being
+ * executed on the current thread are postponed and executed iteratively by the
+ * outermost level in the order they were postponed. This bounds the stack
+ * usage of long chains of continuations executed by `inplace_executor`.
+ *
+ * Default depth is 32. The outermost level of continuations is always executed
+ * immediately so setting depth to 0 has the same effect as setting it to 1.
+ *
+ * Postponed continuations are executed before the thread blocks waiting for
+ * any future so that the waiting can't deadlock on them.
+ */
+void set_inline_continuations_depth(unsigned depth) noexcept;
+
+/**
+ * @headerfile portable_concurrency/future
+ * @ingroup future_hdr
+ *
+ * Returns the value set with @ref set_inline_continuations_depth.
+ */
+unsigned inline_continuations_depth() noexcept;
+
 namespace detail {
 
 using continuation = small_unique_function<void()>;
@@ -21,9 +53,28 @@ public:
 
   void execute();
   bool executed() const;
+  // True once `execute` is called. Unlike `executed` stays false if the stack
+  // is discarded.
+  bool is_ready() const noexcept {
+    return readiness_.load(std::memory_order_acquire) == ready;
+  }
+  // True if nothing is pushed to the stack and it is not executed yet
+  bool empty() const;
+  // Destroys pending continuations without executing them
+  void discard() noexcept;
+
+  // Blocks until `execute` is called. Spins for a while before sleeping and
+  // neither allocates nor pushes any continuation.
+  void wait();
+  // Blocks until `execute` is called or `timeout` expires. Returns true if
+  // the stack is executed.
+  bool wait_for(std::chrono::nanoseconds timeout);
 
 private:
+  enum : std::uint32_t { not_ready, has_waiters, ready };
+
   once_consumable_stack<continuation> stack_;
+  std::atomic<std::uint32_t> readiness_{not_ready};
 };
 
 } // namespace detail
@@ -0,0 +1,31 @@
+#pragma once
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#endif
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+namespace detail {
+
+/**
+ * @internal
+ *
+ * Hint the CPU that the calling thread is busy waiting. Reduces power
+ * consumption and the penalty of leaving the spin loop and gives more
+ * resources to the sibling hyper thread.
+ */
+inline void cpu_relax() noexcept {
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+  _mm_pause();
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  __builtin_ia32_pause();
+#elif defined(__GNUC__) && (defined(__aarch64__) ||                          \
+                             (defined(__arm__) && __ARM_ARCH >= 7))
+  __asm__ __volatile__("yield");
+#endif
+}
+
+} // namespace detail
+} // namespace cxx14_v1
+} // namespace portable_concurrency
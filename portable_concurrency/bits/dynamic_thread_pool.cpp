@@ -0,0 +1,250 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "blocking_observer.h"
+#include "dynamic_thread_pool.h"
+#include "unique_function.hpp"
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+namespace detail {
+
+class dynamic_pool_core final
+    : public blocking_observer,
+      public std::enable_shared_from_this<dynamic_pool_core> {
+public:
+  dynamic_pool_core(std::size_t min_threads, std::size_t max_threads,
+                    std::chrono::milliseconds idle_timeout)
+      : min_threads_{min_threads}, max_threads_{max_threads},
+        idle_timeout_{idle_timeout} {}
+
+  void start();
+  void post(unique_function<void()> &&task);
+  // Stop accepting new tasks
+  void close();
+  // Stop accepting new tasks and abandon queued ones
+  void stop();
+  // Wait for all of the worker threads to exit
+  void wait();
+  std::size_t size() const;
+
+  void blocking_started() noexcept override;
+  void blocking_finished() noexcept override;
+
+private:
+  // Must be called with mutex_ locked
+  bool has_unserved_tasks() const noexcept {
+    return tasks_.size() > idle_ && threads_ - blocked_ < max_threads_;
+  }
+  void spawn_worker();
+
+  static void run(std::shared_ptr<dynamic_pool_core> self,
+                  std::list<std::thread>::iterator thread) noexcept;
+
+private:
+  const std::size_t min_threads_;
+  const std::size_t max_threads_;
+  const std::chrono::milliseconds idle_timeout_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable tasks_cv_;
+  std::condition_variable exit_cv_;
+  std::deque<unique_function<void()>> tasks_;
+  // Threads of the running workers
+  std::list<std::thread> workers_;
+  // Threads of the exited workers which are not joined yet
+  std::list<std::thread> exited_;
+  std::size_t threads_ = 0;
+  // Workers waiting for tasks
+  std::size_t idle_ = 0;
+  // Workers blocked on a future inside of a task
+  std::size_t blocked_ = 0;
+  bool closed_ = false;
+};
+
+void dynamic_pool_core::start() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  while (threads_ < min_threads_)
+    spawn_worker();
+}
+
+void dynamic_pool_core::post(unique_function<void()> &&task) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (closed_)
+      return;
+    tasks_.push_back(std::move(task));
+    if (has_unserved_tasks()) {
+      try {
+        spawn_worker();
+      } catch (...) {
+        // Existing workers will process the task eventually
+        if (threads_ == 0) {
+          task = std::move(tasks_.back());
+          tasks_.pop_back();
+          throw;
+        }
+      }
+    }
+  }
+  tasks_cv_.notify_one();
+}
+
+void dynamic_pool_core::close() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    closed_ = true;
+  }
+  tasks_cv_.notify_all();
+}
+
+void dynamic_pool_core::stop() {
+  std::deque<unique_function<void()>> abandoned;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    closed_ = true;
+    abandoned.swap(tasks_);
+  }
+  tasks_cv_.notify_all();
+  // Destruction of the abandoned tasks may post more tasks to this pool so it
+  // must happen with the mutex unlocked.
+}
+
+void dynamic_pool_core::wait() {
+  close();
+  std::list<std::thread> exited;
+  {
+    std::unique_lock<std::mutex> lock{mutex_};
+    exit_cv_.wait(lock, [this] { return threads_ == 0; });
+    exited.swap(exited_);
+  }
+  // Workers still run thread local objects destructors after they are counted
+  // as exited
+  for (auto &thread : exited)
+    thread.join();
+}
+
+std::size_t dynamic_pool_core::size() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return threads_;
+}
+
+void dynamic_pool_core::blocking_started() noexcept {
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++blocked_;
+  if (!has_unserved_tasks())
+    return;
+  try {
+    spawn_worker();
+  } catch (...) {
+    // Queued tasks are processed once the blocked worker is released
+  }
+}
+
+void dynamic_pool_core::blocking_finished() noexcept {
+  std::lock_guard<std::mutex> lock{mutex_};
+  --blocked_;
+}
+
+// Must be called with mutex_ locked
+void dynamic_pool_core::spawn_worker() {
+  workers_.emplace_back();
+  const auto thread = std::prev(workers_.end());
+  try {
+    // Worker can't access its thread object until the mutex_ is unlocked
+    *thread = std::thread{&dynamic_pool_core::run, shared_from_this(), thread};
+  } catch (...) {
+    workers_.erase(thread);
+    throw;
+  }
+  ++threads_;
+}
+
+// P0443R7 states that if task submitted to static_thread_pool exits via
+// exception then std::terminate is called. Same behavior is used here.
+void dynamic_pool_core::run(std::shared_ptr<dynamic_pool_core> self,
+                            std::list<std::thread>::iterator thread) noexcept {
+  current_blocking_observer() = self.get();
+  std::unique_lock<std::mutex> lock{self->mutex_};
+  for (;;) {
+    if (!self->tasks_.empty()) {
+      {
+        unique_function<void()> task = std::move(self->tasks_.front());
+        self->tasks_.pop_front();
+        lock.unlock();
+        task();
+      }
+      lock.lock();
+      continue;
+    }
+    if (self->closed_)
+      break;
+    ++self->idle_;
+    const bool notified =
+        self->tasks_cv_.wait_for(lock, self->idle_timeout_, [&] {
+          return !self->tasks_.empty() || self->closed_;
+        });
+    --self->idle_;
+    if (!notified && self->threads_ > self->min_threads_)
+      break;
+  }
+  // Workers exited earlier are joined by this one so that the list of exited
+  // threads doesn't grow while the pool lives. This thread is joined by the
+  // next exiting worker or by wait.
+  std::list<std::thread> exited;
+  exited.swap(self->exited_);
+  self->exited_.splice(self->exited_.end(), self->workers_, thread);
+  if (--self->threads_ == 0)
+    self->exit_cv_.notify_all();
+  lock.unlock();
+  for (auto &exited_thread : exited)
+    exited_thread.join();
+  current_blocking_observer() = nullptr;
+}
+
+void post(dynamic_pool_core &core, unique_function<void()> &&task) {
+  core.post(std::move(task));
+}
+
+} // namespace detail
+
+dynamic_thread_pool::dynamic_thread_pool(std::size_t min_threads,
+                                         std::size_t max_threads,
+                                         std::chrono::milliseconds idle_timeout)
+    : core_{[&] {
+        if (max_threads == 0 || max_threads < min_threads)
+          throw std::invalid_argument{
+              "dynamic_thread_pool: invalid threads count limits"};
+        return std::make_shared<detail::dynamic_pool_core>(
+            min_threads, max_threads, idle_timeout);
+      }()} {
+  try {
+    core_->start();
+  } catch (...) {
+    core_->wait();
+    throw;
+  }
+}
+
+dynamic_thread_pool::~dynamic_thread_pool() {
+  stop();
+  wait();
+}
+
+void dynamic_thread_pool::stop() { core_->stop(); }
+
+void dynamic_thread_pool::wait() { core_->wait(); }
+
+std::size_t dynamic_thread_pool::size() const { return core_->size(); }
+
+} // namespace cxx14_v1
+} // namespace portable_concurrency
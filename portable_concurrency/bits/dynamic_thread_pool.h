@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+#include "execution.h"
+#include "unique_function.hpp"
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+
+namespace detail {
+
+class dynamic_pool_core;
+
+void post(dynamic_pool_core &core, unique_function<void()> &&task);
+
+class dynamic_pool_executor {
+public:
+  dynamic_pool_executor(dynamic_pool_core *core) noexcept : core_{core} {}
+
+private:
+  friend void post(dynamic_pool_executor exec, unique_function<void()> fun) {
+    post(*exec.core_, std::move(fun));
+  }
+
+private:
+  dynamic_pool_core *core_;
+};
+
+} // namespace detail
+
+/**
+ * @headerfile portable_concurrency/thread_pool
+ * @ingroup thread_pool
+ * @brief Thread pool which adjusts the number of worker threads to the load.
+ *
+ * Pool starts `min_threads` worker threads. New worker is started when a task
+ * is posted while there are more queued tasks than idle workers or when some
+ * worker blocks waiting for a future or a latch while there are queued tasks
+ * nobody can pick up. Blocked workers do not count towards the `max_threads`
+ * limit so a task waiting for the result of another task posted to the same
+ * pool can't deadlock it. Worker exits if it stays idle for `idle_timeout` and
+ * there are more than `min_threads` workers.
+ */
+class dynamic_thread_pool {
+public:
+  using executor_type = detail::dynamic_pool_executor;
+
+  /**
+   * @throws std::invalid_argument if `max_threads` is zero or less than
+   * `min_threads`
+   */
+  dynamic_thread_pool(
+      std::size_t min_threads, std::size_t max_threads,
+      std::chrono::milliseconds idle_timeout = std::chrono::seconds{10});
+
+  dynamic_thread_pool(const dynamic_thread_pool &) = delete;
+  dynamic_thread_pool &operator=(const dynamic_thread_pool &) = delete;
+
+  /// stop accepting incoming work and wait for work to drain
+  ~dynamic_thread_pool();
+
+  /// signal all work to complete
+  void stop();
+
+  /// wait for all threads in the thread pool to complete
+  void wait();
+
+  /// current number of worker threads
+  std::size_t size() const;
+
+  executor_type executor() noexcept { return {core_.get()}; }
+
+private:
+  std::shared_ptr<detail::dynamic_pool_core> core_;
+};
+
+} // namespace cxx14_v1
+
+template <>
+struct is_executor<cxx14_v1::dynamic_thread_pool::executor_type>
+    : std::true_type {};
+
+} // namespace portable_concurrency
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+namespace detail {
+
+/**
+ * @internal
+ *
+ * Condition variable analog which doesn't require the waited condition to be
+ * protected by a mutex. Waiting is split into three steps:
+ * @li `prepare_wait` registers the thread as a waiter and returns the key
+ * @li the thread checks the condition once again
+ * @li either `cancel_wait` if the condition is satisfied or `commit_wait` with
+ * the key obtained on the first step in order to block
+ *
+ * Notifying threads make the condition true and then call `notify_one` or
+ * `notify_all`. Both of them only touch the mutex and the condition variable if
+ * there are registered waiters, so notification of an event nobody waits for
+ * costs one fence and one atomic load.
+ */
+class event_count {
+public:
+  using key_type = std::uint32_t;
+
+  key_type prepare_wait() noexcept {
+    const auto prev = state_.fetch_add(waiter_inc, std::memory_order_seq_cst);
+    // Condition recheck loads must not be reordered before waiter registration
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return epoch(prev);
+  }
+
+  void cancel_wait() noexcept {
+    state_.fetch_sub(waiter_inc, std::memory_order_relaxed);
+  }
+
+  void commit_wait(key_type key) {
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      cv_.wait(lock, [&] {
+        return epoch(state_.load(std::memory_order_relaxed)) != key;
+      });
+    }
+    state_.fetch_sub(waiter_inc, std::memory_order_relaxed);
+  }
+
+  // Returns false if the time point is reached before notification
+  template <typename Clock, typename Duration>
+  bool commit_wait_until(key_type key,
+                         const std::chrono::time_point<Clock, Duration> &tp) {
+    bool notified;
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      notified = cv_.wait_until(lock, tp, [&] {
+        return epoch(state_.load(std::memory_order_relaxed)) != key;
+      });
+    }
+    state_.fetch_sub(waiter_inc, std::memory_order_relaxed);
+    return notified;
+  }
+
+  // Returns false if there are no waiters to notify
+  bool notify_one() noexcept {
+    if (!advance_epoch())
+      return false;
+    cv_.notify_one();
+    return true;
+  }
+
+  // Wakes up at most `count` waiters
+  void notify(unsigned count) noexcept {
+    if (count == 0 || !advance_epoch())
+      return;
+    if (count >= waiters()) {
+      cv_.notify_all();
+      return;
+    }
+    while (count-- > 0)
+      cv_.notify_one();
+  }
+
+  void notify_all() noexcept {
+    if (!advance_epoch())
+      return;
+    cv_.notify_all();
+  }
+
+  // Number of threads between prepare_wait and cancel_wait/commit_wait
+  unsigned waiters() const noexcept {
+    return static_cast<unsigned>(state_.load(std::memory_order_relaxed) &
+                                 waiters_mask);
+  }
+
+private:
+  static constexpr std::uint64_t waiter_inc = 1;
+  static constexpr std::uint64_t waiters_mask = 0xffffffff;
+  static constexpr std::uint64_t epoch_inc = std::uint64_t{1} << 32;
+
+  static key_type epoch(std::uint64_t state) noexcept {
+    return static_cast<key_type>(state >> 32);
+  }
+
+  bool advance_epoch() noexcept {
+    // Pairs with the seq_cst RMW in prepare_wait: either the waiter sees the
+    // condition change on recheck or we see the waiter registered here.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if ((state_.load(std::memory_order_relaxed) & waiters_mask) == 0)
+      return false;
+    // Epoch is changed under the mutex so that it can't happen between the
+    // predicate check and blocking on the condition variable in commit_wait.
+    std::lock_guard<std::mutex> lock{mutex_};
+    state_.fetch_add(epoch_inc, std::memory_order_relaxed);
+    return true;
+  }
+
+private:
+  std::atomic<std::uint64_t> state_{0};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+} // namespace detail
+} // namespace cxx14_v1
+} // namespace portable_concurrency
@@ -50,6 +50,27 @@ constexpr inplace_executor_t inplace_executor;
 
 template <> struct is_executor<inplace_executor_t> : std::true_type {};
 
+/**
+ * @headerfile portable_concurrency/execution
+ * @ingroup execution
+ * @brief Schedules execution of all of the tasks from the range `[first, last)`
+ * on the executor `exec`.
+ *
+ * Tasks are moved from the range. This implementation calls @ref post for each
+ * task. Executor types may provide ADL discoverable `post_bulk` overload which
+ * schedules the whole range with a single synchronization operation. Library
+ * functions submitting many tasks at once use such overload when available.
+ *
+ * The function participates in overload resolution only if
+ * `is_executor<E>::value` is `true`.
+ */
+template <typename E, typename InputIt>
+auto post_bulk(E exec, InputIt first, InputIt last)
+    -> std::enable_if_t<is_executor<E>::value> {
+  for (; first != last; ++first)
+    post(exec, std::move(*first));
+}
+
 } // namespace portable_concurrency
 
 #ifdef DOXYGEN
@@ -0,0 +1,103 @@
+#include <climits>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+#if defined(__linux__)
+#include <ctime>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "futex.h"
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+namespace detail {
+
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+              "Atomic word must have the same layout as the underlying type");
+
+#if defined(__linux__)
+
+namespace {
+
+long futex(const std::atomic<std::uint32_t> &word, int op, std::uint32_t val,
+           const timespec *timeout = nullptr) noexcept {
+  return ::syscall(SYS_futex,
+                   reinterpret_cast<const std::uint32_t *>(&word), op, val,
+                   timeout, nullptr, 0);
+}
+
+} // namespace
+
+void futex_wait(const std::atomic<std::uint32_t> &word,
+                std::uint32_t expected) noexcept {
+  futex(word, FUTEX_WAIT_PRIVATE, expected);
+}
+
+void futex_wait_for(const std::atomic<std::uint32_t> &word,
+                    std::uint32_t expected,
+                    std::chrono::nanoseconds timeout) noexcept {
+  const auto secs = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+  timespec ts;
+  ts.tv_sec = static_cast<time_t>(secs.count());
+  ts.tv_nsec = static_cast<long>((timeout - secs).count());
+  futex(word, FUTEX_WAIT_PRIVATE, expected, &ts);
+}
+
+void futex_wake_all(const std::atomic<std::uint32_t> &word) noexcept {
+  futex(word, FUTEX_WAKE_PRIVATE, INT_MAX);
+}
+
+#else
+
+namespace {
+
+struct parking_bucket {
+  std::mutex mutex;
+  std::condition_variable cv;
+};
+
+constexpr std::size_t buckets_count = 64;
+
+parking_bucket &bucket_for(const void *addr) noexcept {
+  static parking_bucket buckets[buckets_count];
+  return buckets[(reinterpret_cast<std::uintptr_t>(addr) >> 4) %
+                 buckets_count];
+}
+
+} // namespace
+
+void futex_wait(const std::atomic<std::uint32_t> &word,
+                std::uint32_t expected) noexcept {
+  auto &bucket = bucket_for(&word);
+  std::unique_lock<std::mutex> lock{bucket.mutex};
+  if (word.load(std::memory_order_relaxed) == expected)
+    bucket.cv.wait(lock);
+}
+
+void futex_wait_for(const std::atomic<std::uint32_t> &word,
+                    std::uint32_t expected,
+                    std::chrono::nanoseconds timeout) noexcept {
+  auto &bucket = bucket_for(&word);
+  std::unique_lock<std::mutex> lock{bucket.mutex};
+  if (word.load(std::memory_order_relaxed) == expected)
+    bucket.cv.wait_for(lock, timeout);
+}
+
+void futex_wake_all(const std::atomic<std::uint32_t> &word) noexcept {
+  auto &bucket = bucket_for(&word);
+  // Waiter which has seen the old value under the lock is already blocked on
+  // the condition variable once the lock is acquired here.
+  { std::lock_guard<std::mutex> lock{bucket.mutex}; }
+  bucket.cv.notify_all();
+}
+
+#endif
+
+} // namespace detail
+} // namespace cxx14_v1
+} // namespace portable_concurrency
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+namespace detail {
+
+/**
+ * @internal
+ *
+ * Blocks the calling thread while `word` holds the `expected` value. Might
+ * return spuriously so the caller must recheck the value. Uses futex syscall
+ * on Linux and a table of mutexes and condition variables keyed by the word
+ * address on other platforms.
+ */
+void futex_wait(const std::atomic<std::uint32_t> &word,
+                std::uint32_t expected) noexcept;
+
+/**
+ * @internal
+ *
+ * Same as `futex_wait` but returns after `timeout` even if the value of the
+ * `word` is not changed.
+ */
+void futex_wait_for(const std::atomic<std::uint32_t> &word,
+                    std::uint32_t expected,
+                    std::chrono::nanoseconds timeout) noexcept;
+
+/**
+ * @internal
+ *
+ * Wakes all of the threads blocked in `futex_wait` on the `word`. Must be
+ * called after the value of the word is changed. Only the address of the word
+ * is used so it is safe to call this function after the word is destroyed.
+ */
+void futex_wake_all(const std::atomic<std::uint32_t> &word) noexcept;
+
+} // namespace detail
+} // namespace cxx14_v1
+} // namespace portable_concurrency
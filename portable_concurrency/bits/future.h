@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <exception>
 #include <memory>
 #include <type_traits>
 
@@ -8,18 +9,76 @@
 
 #include "concurrency_type_traits.h"
 #include "coro.h"
+#include "either.h"
+#include "future_state.h"
+#include "state_ptr.h"
 
 #include <portable_concurrency/bits/config.h>
 
 namespace portable_concurrency {
 inline namespace cxx14_v1 {
 
+namespace detail {
+
+/**
+ * @internal
+ *
+ * Result of the operation stored directly in the future object which is
+ * created ready.
+ */
+template <typename T>
+using ready_value_t =
+    either<monostate, state_storage_t<T>, std::exception_ptr>;
+
+// Only void, references and scalars are kept in the future object: they are
+// small, nothrow movable and can be detected without requiring T to be
+// complete. Futures of other types keep the value in the shared state and are
+// not any larger than a pointer.
+template <typename T>
+using stored_inline =
+    std::integral_constant<bool, std::is_void<T>::value ||
+                                     std::is_reference<T>::value ||
+                                     std::is_scalar<T>::value>;
+
+/**
+ * @internal
+ *
+ * Storage of the ready value in the future object. Empty for the types which
+ * are never stored inline.
+ */
+template <typename T, bool = stored_inline<T>::value>
+class ready_value_storage {
+protected:
+  ready_value_storage() noexcept = default;
+  ready_value_storage(ready_value_t<T> &&value) noexcept
+      : value_(std::move(value)) {}
+
+  bool has_ready_value() const noexcept { return !value_.empty(); }
+
+  ready_value_t<T> take_ready_value() noexcept { return std::move(value_); }
+
+private:
+  ready_value_t<T> value_;
+};
+
+template <typename T> class ready_value_storage<T, false> {
+protected:
+  bool has_ready_value() const noexcept { return false; }
+  ready_value_t<T> take_ready_value() noexcept { return {}; }
+};
+
+template <typename T> ready_value_t<T> take_ready_value(future<T> &);
+template <typename T>
+const state_ptr<future_state<T>> &existing_state_of(const future<T> &) noexcept;
+
+} // namespace detail
+
 /**
  * @ingroup future_hdr
  * @brief The class template future provides a mechanism to access the result of
  * asynchronous operations.
  */
-template <typename T> class future {
+template <typename T> class future : detail::ready_value_storage<T> {
   static_assert(
       !detail::is_future<T>::value,
       "future<future<T>> and future<shared_future<T>> are not allowed");
@@ -63,11 +122,17 @@ public:
 
   /**
    * Creates shared_future object and move ownership on the shared state
-   * associated to this object to it
+   * associated to this object to it. Shared state is allocated at this point
+   * if this future was created ready by `make_ready_future` or
+   * `make_exceptional_future`.
+   *
+   * @note Only futures of void, reference or scalar types may hold the ready
+   * value without a shared state. For them this function may throw
+   * `std::bad_alloc`.
    *
    * @post this->valid() == false
    */
-  shared_future<T> share() noexcept;
+  shared_future<T> share() noexcept(!detail::stored_inline<T>::value);
 
   /**
    * @brief Get the result of asynchronous operation stored in this future
@@ -153,6 +218,30 @@ public:
   template <typename E, typename F>
   PC_NODISCARD detail::cnt_future_t<F, T> next(E &&exec, F &&f);
 
+  template <typename Alloc, typename F>
+  PC_NODISCARD detail::cnt_future_t<F, future<T>>
+  then(std::allocator_arg_t, const Alloc &allocator, F &&f);
+
+  template <typename Alloc, typename F>
+  PC_NODISCARD detail::add_future_t<detail::promise_arg_t<F, future>>
+  then(std::allocator_arg_t, const Alloc &allocator, F &&f);
+
+  template <typename Alloc, typename E, typename F>
+  PC_NODISCARD detail::cnt_future_t<F, future<T>>
+  then(std::allocator_arg_t, const Alloc &allocator, E &&exec, F &&f);
+
+  template <typename Alloc, typename E, typename F>
+  PC_NODISCARD detail::add_future_t<detail::promise_arg_t<F, future>>
+  then(std::allocator_arg_t, const Alloc &allocator, E &&exec, F &&f);
+
+  template <typename Alloc, typename F>
+  PC_NODISCARD detail::cnt_future_t<F, T>
+  next(std::allocator_arg_t, const Alloc &allocator, F &&f);
+
+  template <typename Alloc, typename E, typename F>
+  PC_NODISCARD detail::cnt_future_t<F, T>
+  next(std::allocator_arg_t, const Alloc &allocator, E &&exec, F &&f);
+
   /**
    * Prevents cancellation of the operations of this future value calculation on
    * its destruction.
@@ -162,7 +251,8 @@ public:
   future detach();
 
   // implementation detail
-  future(std::shared_ptr<detail::future_state<T>> &&state) noexcept;
+  future(detail::state_ptr<detail::future_state<T>> &&state) noexcept;
+  future(detail::ready_value_t<T> &&value) noexcept;
 
 #if defined(PC_HAS_COROUTINES)
   // Coroutines TS support
@@ -174,13 +264,19 @@ public:
 
 private:
   friend class shared_future<T>;
-  friend std::shared_ptr<detail::future_state<T>> &
+  friend detail::state_ptr<detail::future_state<T>> &
   detail::state_of<T>(future<T> &);
-  friend std::shared_ptr<detail::future_state<T>>
+  friend detail::state_ptr<detail::future_state<T>>
   detail::state_of<T>(future<T> &&);
+  friend detail::ready_value_t<T> detail::take_ready_value<T>(future<T> &);
+  friend const detail::state_ptr<detail::future_state<T>> &
+  detail::existing_state_of<T>(const future<T> &) noexcept;
+
+  // Moves ready value into the newly allocated shared state if required
+  detail::state_ptr<detail::future_state<T>> &materialize();
 
 private:
-  std::shared_ptr<detail::future_state<T>> state_;
+  detail::state_ptr<detail::future_state<T>> state_;
 };
 
 template <> void future<void>::get();
@@ -12,21 +12,31 @@
 namespace portable_concurrency {
 inline namespace cxx14_v1 {
 
-template <typename T> shared_future<T> future<T>::share() noexcept {
+template <typename T>
+shared_future<T> future<T>::share() noexcept(!detail::stored_inline<T>::value) {
   return {std::move(*this)};
 }
 
 template <typename T> T future<T>::get() {
-  if (!state_)
-    detail::throw_no_state();
+  if (!state_) {
+    if (!this->has_ready_value())
+      detail::throw_no_state();
+    auto value = this->take_ready_value();
+    if (value.state() == 2)
+      std::rethrow_exception(value.get(detail::in_place_index_t<2>{}));
+    return std::move(value.get(detail::in_place_index_t<1>{}));
+  }
   wait();
   auto state = std::move(state_);
   return std::move(state->value_ref());
 }
 
 template <typename T> void future<T>::wait() const {
-  if (!state_)
-    detail::throw_no_state();
+  if (!state_) {
+    if (!this->has_ready_value())
+      detail::throw_no_state();
+    return;
+  }
   detail::wait(*state_);
 }
 
@@ -35,8 +45,11 @@ template <typename T>
 template <typename Rep, typename Period>
 future_status
 future<T>::wait_for(const std::chrono::duration<Rep, Period> &rel_time) const {
-  if (!state_)
-    detail::throw_no_state();
+  if (!state_) {
+    if (!this->has_ready_value())
+      detail::throw_no_state();
+    return future_status::ready;
+  }
   // const_cast below:
   //  * can't introduce thread safety issues since adding notification is thread
   //  safe
@@ -53,8 +66,11 @@ template <typename T>
 template <typename Clock, typename Duration>
 future_status future<T>::wait_until(
     const std::chrono::time_point<Clock, Duration> &abs_time) const {
-  if (!state_)
-    detail::throw_no_state();
+  if (!state_) {
+    if (!this->has_ready_value())
+      detail::throw_no_state();
+    return future_status::ready;
+  }
   // const_cast below:
   //  * can't introduce thread safety issues since adding notification is thread
   //  safe
@@ -69,20 +85,28 @@ future_status future<T>::wait_until(
 #endif
 
 template <typename T> bool future<T>::valid() const noexcept {
-  return static_cast<bool>(state_);
+  return state_ || this->has_ready_value();
 }
 
 template <typename T> bool future<T>::is_ready() const {
-  if (!state_)
-    detail::throw_no_state();
+  if (!state_) {
+    if (!this->has_ready_value())
+      detail::throw_no_state();
+    return true;
+  }
   return state_->continuations().executed();
 }
 
 template <typename T>
 template <typename F>
 void future<T>::notify(F &&notification) {
-  if (!state_)
-    detail::throw_no_state();
+  if (!state_) {
+    if (!this->has_ready_value())
+      detail::throw_no_state();
+    std::decay_t<F> func = std::forward<F>(notification);
+    func();
+    return;
+  }
   state_->continuations().push(std::forward<F>(notification));
 }
 
@@ -90,8 +114,12 @@ template <typename T>
 template <typename E, typename F>
 void future<T>::notify(E &&exec, F &&notification) {
   static_assert(is_executor<std::decay_t<E>>::value, "E must be an executor");
-  if (!state_)
-    detail::throw_no_state();
+  if (!state_) {
+    if (!this->has_ready_value())
+      detail::throw_no_state();
+    post(exec, std::decay_t<F>{std::forward<F>(notification)});
+    return;
+  }
   state_->continuations().push(
       [exec = std::forward<E>(exec),
        notification = std::forward<F>(notification)]() mutable {
@@ -116,14 +144,75 @@ template <typename T>
 template <typename E, typename F>
 PC_NODISCARD detail::cnt_future_t<F, future<T>> future<T>::then(E &&exec,
                                                                 F &&f) {
+  return then(std::allocator_arg, std::allocator<void>{},
+              std::forward<E>(exec), std::forward<F>(f));
+}
+
+template <typename T>
+template <typename E, typename F>
+PC_NODISCARD detail::add_future_t<detail::promise_arg_t<F, future<T>>>
+future<T>::then(E &&exec, F &&f) {
+  return then(std::allocator_arg, std::allocator<void>{},
+              std::forward<E>(exec), std::forward<F>(f));
+}
+
+template <typename T>
+template <typename F>
+PC_NODISCARD detail::cnt_future_t<F, T> future<T>::next(F &&f) {
+  return next(inplace_executor, std::forward<F>(f));
+}
+
+template <typename T>
+template <typename E, typename F>
+PC_NODISCARD detail::cnt_future_t<F, T> future<T>::next(E &&exec, F &&f) {
+  return next(std::allocator_arg, std::allocator<void>{},
+              std::forward<E>(exec), std::forward<F>(f));
+}
+
+template <typename T>
+template <typename Alloc, typename F>
+PC_NODISCARD detail::cnt_future_t<F, future<T>>
+future<T>::then(std::allocator_arg_t, const Alloc &allocator, F &&f) {
+  return then(std::allocator_arg, allocator, inplace_executor,
+              std::forward<F>(f));
+}
+
+template <typename T>
+template <typename Alloc, typename F>
+PC_NODISCARD detail::add_future_t<detail::promise_arg_t<F, future<T>>>
+future<T>::then(std::allocator_arg_t, const Alloc &allocator, F &&f) {
+  return then(std::allocator_arg, allocator, inplace_executor,
+              std::forward<F>(f));
+}
+
+/**
+ * Attaches continuation function `f` to this future object. Shared state of
+ * the returned future and the node of this future continuations stack are
+ * allocated with the `allocator`. [EXTENSION]
+ *
+ * If this future is ready and `exec` is `inplace_executor` the continuation is
+ * invoked immediately and its result is stored directly in the returned future
+ * whenever possible.
+ */
+template <typename T>
+template <typename Alloc, typename E, typename F>
+PC_NODISCARD detail::cnt_future_t<F, future<T>>
+future<T>::then(std::allocator_arg_t, const Alloc &allocator, E &&exec,
+                F &&f) {
   static_assert(is_executor<std::decay_t<E>>::value, "E must be an executor");
   using result_type =
       detail::remove_future_t<detail::cnt_result_t<F, future<T>>>;
-  if (!state_)
+  if (detail::is_inplace_executor<E>::value && is_ready()) {
+    return detail::run_eagerly<result_type>(
+        detail::eager_inline_result<result_type,
+                                    detail::cnt_result_t<F, future<T>>>{},
+        allocator, std::forward<F>(f), future<T>{std::move(*this)});
+  }
+  if (!materialize())
     detail::throw_no_state();
-  detail::continuations_stack &subscriptions = state_->continuations();
+  detail::future_state_base &state_ref = *state_;
   return detail::make_then_state<result_type>(
-      subscriptions, std::forward<E>(exec),
+      state_ref, allocator, std::forward<E>(exec),
       detail::decorate_unique_then<result_type, T, F>(std::forward<F>(f),
                                                       std::move(state_)));
 }
@@ -141,74 +230,127 @@ PC_NODISCARD detail::cnt_future_t<F, future<T>> future<T>::then(E &&exec,
  *  * to move it into another promise which will be used to set value or
  * exception by some other operation
  *
+ * Shared state of the returned future and the node of this future
+ * continuations stack are allocated with the `allocator`.
+ *
  * If continuation function exits via exception std::terminate is called.
  */
 template <typename T>
-template <typename E, typename F>
+template <typename Alloc, typename E, typename F>
 PC_NODISCARD detail::add_future_t<detail::promise_arg_t<F, future<T>>>
-future<T>::then(E &&exec, F &&f) {
+future<T>::then(std::allocator_arg_t, const Alloc &allocator, E &&exec,
+                F &&f) {
   static_assert(is_executor<std::decay_t<E>>::value, "E must be an executor");
   using result_type = detail::promise_arg_t<F, future<T>>;
-  if (!state_)
+  if (!materialize())
     detail::throw_no_state();
-  detail::continuations_stack &subscriptions = state_->continuations();
+  detail::future_state_base &state_ref = *state_;
   return detail::make_then_state<result_type>(
-      subscriptions, std::forward<E>(exec),
+      state_ref, allocator, std::forward<E>(exec),
       [f = std::forward<F>(f), parent = std::move(state_)](
-          std::shared_ptr<detail::shared_state<result_type>>
+          detail::state_ptr<detail::shared_state<result_type>>
               state) mutable noexcept {
-        promise<result_type> p{std::exchange(state, nullptr)};
+        promise<result_type> p{std::move(state)};
         ::portable_concurrency::detail::invoke(f, std::move(p),
                                                future<T>{std::move(parent)});
       });
 }
 
 template <typename T>
-template <typename F>
-PC_NODISCARD detail::cnt_future_t<F, T> future<T>::next(F &&f) {
-  return next(inplace_executor, std::forward<F>(f));
+template <typename Alloc, typename F>
+PC_NODISCARD detail::cnt_future_t<F, T>
+future<T>::next(std::allocator_arg_t, const Alloc &allocator, F &&f) {
+  return next(std::allocator_arg, allocator, inplace_executor,
+              std::forward<F>(f));
 }
 
 template <>
-template <typename E, typename F>
-PC_NODISCARD detail::cnt_future_t<F, void> future<void>::next(E &&exec, F &&f) {
+template <typename Alloc, typename E, typename F>
+PC_NODISCARD detail::cnt_future_t<F, void>
+future<void>::next(std::allocator_arg_t, const Alloc &allocator, E &&exec,
+                   F &&f) {
   static_assert(is_executor<std::decay_t<E>>::value, "E must be an executor");
   using result_type = detail::remove_future_t<detail::cnt_result_t<F, void>>;
-  if (!state_)
+  if (detail::is_inplace_executor<E>::value && is_ready()) {
+    return detail::run_eagerly<result_type>(
+        detail::eager_inline_result<result_type,
+                                    detail::cnt_result_t<F, void>>{},
+        allocator,
+        [&f](future<void> &&parent) -> decltype(auto) {
+          parent.get();
+          return detail::invoke(std::forward<F>(f));
+        },
+        future<void>{std::move(*this)});
+  }
+  if (!materialize())
     detail::throw_no_state();
-  detail::continuations_stack &subscriptions = state_->continuations();
+  detail::future_state_base &state_ref = *state_;
   return detail::make_then_state<result_type>(
-      subscriptions, std::forward<E>(exec),
+      state_ref, allocator, std::forward<E>(exec),
       detail::decorate_void_next<result_type, F>(std::forward<F>(f),
                                                  std::move(state_)));
 }
 
 template <typename T>
-template <typename E, typename F>
-PC_NODISCARD detail::cnt_future_t<F, T> future<T>::next(E &&exec, F &&f) {
+template <typename Alloc, typename E, typename F>
+PC_NODISCARD detail::cnt_future_t<F, T>
+future<T>::next(std::allocator_arg_t, const Alloc &allocator, E &&exec,
+                F &&f) {
   static_assert(is_executor<std::decay_t<E>>::value, "E must be an executor");
   using result_type = detail::remove_future_t<detail::cnt_result_t<F, T>>;
-  if (!state_)
+  if (detail::is_inplace_executor<E>::value && is_ready()) {
+    return detail::run_eagerly<result_type>(
+        detail::eager_inline_result<result_type,
+                                    detail::cnt_result_t<F, T>>{},
+        allocator,
+        [&f](future<T> &&parent) -> decltype(auto) {
+          return detail::invoke(std::forward<F>(f), parent.get());
+        },
+        future<T>{std::move(*this)});
+  }
+  if (!materialize())
     detail::throw_no_state();
-  detail::continuations_stack &subscriptions = state_->continuations();
+  detail::future_state_base &state_ref = *state_;
   return detail::make_then_state<result_type>(
-      subscriptions, std::forward<E>(exec),
+      state_ref, allocator, std::forward<E>(exec),
       detail::decorate_unique_next<result_type, T, F>(std::forward<F>(f),
                                                       std::move(state_)));
 }
 
 template <typename T> future<T> future<T>::detach() {
-  if (!state_)
-    detail::throw_no_state();
+  if (!state_) {
+    // Nothing to cancel if the value is already known
+    if (!this->has_ready_value())
+      detail::throw_no_state();
+    return std::move(*this);
+  }
   auto &state_ref = *state_;
   state_ref.push([captured_state = state_] {});
   return std::move(*this);
 }
 
 template <typename T>
-future<T>::future(std::shared_ptr<detail::future_state<T>> &&state) noexcept
+future<T>::future(detail::state_ptr<detail::future_state<T>> &&state) noexcept
     : state_(std::move(state)) {}
 
+template <typename T>
+future<T>::future(detail::ready_value_t<T> &&value) noexcept
+    : detail::ready_value_storage<T>(std::move(value)) {}
+
+template <typename T>
+detail::state_ptr<detail::future_state<T>> &future<T>::materialize() {
+  if (state_ || !this->has_ready_value())
+    return state_;
+  auto value = this->take_ready_value();
+  auto state = detail::make_state<detail::shared_state<T>>();
+  if (value.state() == 2)
+    state->set_exception(value.get(detail::in_place_index_t<2>{}));
+  else
+    state->emplace(std::move(value.get(detail::in_place_index_t<1>{})));
+  state_ = std::move(state);
+  return state_;
+}
+
 #if defined(PC_HAS_COROUTINES)
 template <typename T> bool future<T>::await_ready() const noexcept {
   return is_ready();
@@ -218,17 +360,27 @@ template <typename T> T future<T>::await_resume() { return get(); }
 
 template <typename T>
 void future<T>::await_suspend(detail::coroutine_handle<> handle) {
-  state_->push(std::move(handle));
+  materialize()->push(std::move(handle));
 }
 #endif
 
 namespace detail {
 
-template <typename T> std::shared_ptr<future_state<T>> &state_of(future<T> &f) {
-  return f.state_;
+template <typename T> state_ptr<future_state<T>> &state_of(future<T> &f) {
+  return f.materialize();
+}
+
+template <typename T> state_ptr<future_state<T>> state_of(future<T> &&f) {
+  return std::move(f.materialize());
 }
 
-template <typename T> std::shared_ptr<future_state<T>> state_of(future<T> &&f) {
+template <typename T> ready_value_t<T> take_ready_value(future<T> &f) {
+  return f.take_ready_value();
+}
+
+template <typename T>
+const state_ptr<future_state<T>> &
+existing_state_of(const future<T> &f) noexcept {
   return f.state_;
 }
 
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <type_traits>
 
 #include "fwd.h"
 
 #include "continuations_stack.h"
+#include "memory_pool.h"
+#include "state_ptr.h"
 
 namespace portable_concurrency {
 inline namespace cxx14_v1 {
@@ -20,8 +24,22 @@ using state_storage_t = std::conditional_t<
                        std::reference_wrapper<std::remove_reference_t<T>>,
                        std::remove_const_t<T>>>;
 
-struct future_state_base {
-  virtual ~future_state_base() = default;
+/**
+ * @internal
+ *
+ * Base class of all of the shared states. Shared state is reference counted
+ * intrusively with @ref state_ptr and @ref weak_state_ptr. Both strong and weak
+ * counters are packed into a single atomic word. Strong references are held by
+ * the consumers of the value, weak ones by its producers. When the last strong
+ * reference is released the `dispose` function is called to destroy the value
+ * and everything else owned by the state. The state itself is destroyed when
+ * there are no weak references left.
+ */
+class future_state_base {
+public:
+  future_state_base() = default;
+  future_state_base(const future_state_base &) = delete;
+  future_state_base &operator=(const future_state_base &) = delete;
 
   virtual continuations_stack &continuations() = 0;
   // May be overloaded by shared_state with custom allocator in order to
@@ -31,6 +49,81 @@ struct future_state_base {
   // returns nullptr if there is no error. UB if called before continuations are
   // executed.
   virtual std::exception_ptr exception() = 0;
+
+  void add_ref() noexcept {
+    refs_.fetch_add(strong_ref, std::memory_order_relaxed);
+  }
+
+  void release() noexcept {
+    const auto prev = refs_.fetch_sub(strong_ref, std::memory_order_acq_rel);
+    if (prev >= 2 * strong_ref)
+      return;
+    dispose();
+    // Nobody else can reference the state if the only weak reference is the
+    // one shared by all of the strong references
+    if (prev == strong_ref + weak_ref)
+      destroy();
+    else
+      release_weak();
+  }
+
+  // Acquires strong reference unless the state is already disposed
+  bool try_add_ref() noexcept {
+    auto refs = refs_.load(std::memory_order_relaxed);
+    do {
+      if (refs < strong_ref)
+        return false;
+    } while (!refs_.compare_exchange_weak(refs, refs + strong_ref,
+                                          std::memory_order_acq_rel,
+                                          std::memory_order_relaxed));
+    return true;
+  }
+
+  void add_weak_ref() noexcept {
+    refs_.fetch_add(weak_ref, std::memory_order_relaxed);
+  }
+
+  void release_weak() noexcept {
+    if (refs_.fetch_sub(weak_ref, std::memory_order_acq_rel) == weak_ref)
+      destroy();
+  }
+
+  bool expired() const noexcept {
+    return refs_.load(std::memory_order_acquire) < strong_ref;
+  }
+
+  // Shared states are allocated from the library memory pool. Virtual
+  // destructor makes `delete` pass the size of the most derived object.
+  static void *operator new(std::size_t size) { return pool_allocate(size); }
+  static void operator delete(void *ptr, std::size_t size) noexcept {
+    pool_deallocate(ptr, size);
+  }
+#if defined(__cpp_aligned_new)
+  // Class scope overloads above hide the global aligned ones
+  static void *operator new(std::size_t size, std::align_val_t alignment) {
+    return pool_allocate(size, static_cast<std::size_t>(alignment));
+  }
+  static void operator delete(void *ptr, std::size_t size,
+                              std::align_val_t alignment) noexcept {
+    pool_deallocate(ptr, size, static_cast<std::size_t>(alignment));
+  }
+#endif
+
+protected:
+  virtual ~future_state_base() = default;
+
+  // Destroys everything owned by the state. Called once when the last strong
+  // reference is released.
+  virtual void dispose() noexcept {}
+  // Destroys the state and deallocates memory occupied by it
+  virtual void destroy() noexcept { delete this; }
+
+private:
+  static constexpr std::uint64_t weak_ref = 1;
+  static constexpr std::uint64_t strong_ref = std::uint64_t{1} << 32;
+
+  // All strong references share single weak reference
+  std::atomic<std::uint64_t> refs_{strong_ref + weak_ref};
 };
 
 void wait(future_state_base &state);
@@ -39,6 +132,10 @@ template <typename T> struct future_state : future_state_base {
   // throws stored exception if there is no value. UB if called before
   // continuations are executed.
   virtual state_storage_t<T> &value_ref() = 0;
+
+  // Returns this state if it is able to notify the shared_state unwrapping it
+  // directly instead of running continuation pushed by it.
+  virtual shared_state<T> *as_shared_state() noexcept { return nullptr; }
 };
 
 } // namespace detail
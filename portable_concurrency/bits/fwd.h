@@ -1,7 +1,5 @@
 #pragma once
 
-#include <memory>
-
 namespace portable_concurrency {
 inline namespace cxx14_v1 {
 
@@ -17,14 +15,16 @@ template <typename T> class shared_future;
 
 namespace detail {
 template <typename T> struct future_state;
+template <typename T> class shared_state;
+template <typename S> class state_ptr;
 
-template <typename T> std::shared_ptr<future_state<T>> &state_of(future<T> &);
-template <typename T> std::shared_ptr<future_state<T>> state_of(future<T> &&);
+template <typename T> state_ptr<future_state<T>> &state_of(future<T> &);
+template <typename T> state_ptr<future_state<T>> state_of(future<T> &&);
 
 template <typename T>
-std::shared_ptr<future_state<T>> &state_of(shared_future<T> &);
+state_ptr<future_state<T>> &state_of(shared_future<T> &);
 template <typename T>
-std::shared_ptr<future_state<T>> state_of(shared_future<T> &&);
+state_ptr<future_state<T>> state_of(shared_future<T> &&);
 } // namespace detail
 
 } // namespace cxx14_v1
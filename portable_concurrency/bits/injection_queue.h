@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+namespace detail {
+
+/**
+ * @internal
+ *
+ * Intrusive unbounded FIFO queue based on the Dmitry Vyukov's MPSC node based
+ * queue. `Node` type must be default constructible and have a member
+ * `std::atomic<Node*> next`.
+ *
+ * Push is wait-free and can be called from any number of threads. Pop can also
+ * be called from any thread but consumers are serialized with a try-lock: if
+ * some other thread is popping at the moment `try_pop` gives up immediately
+ * instead of waiting. Use `size` to distinguish between empty queue and
+ * contended one.
+ *
+ * Queue never owns pushed nodes.
+ */
+template <typename Node> class injection_queue {
+public:
+  injection_queue() noexcept : head_{&stub_}, tail_{&stub_} {}
+
+  injection_queue(const injection_queue &) = delete;
+  injection_queue &operator=(const injection_queue &) = delete;
+
+  void push(Node *node) noexcept { push(node, node, 1); }
+
+  // Push the chain of `count` nodes linked via `next` field from `first` to
+  // `last` with a single atomic operation.
+  void push(Node *first, Node *last, std::size_t count) noexcept {
+    // Size is increased before the nodes become reachable so it never
+    // underestimates the number of queued and being pushed nodes.
+    size_.fetch_add(count, std::memory_order_seq_cst);
+    link(first, last);
+  }
+
+  Node *try_pop() noexcept {
+    if (size_.load(std::memory_order_relaxed) == 0)
+      return nullptr;
+    if (consumer_lock_.test_and_set(std::memory_order_acquire))
+      return nullptr;
+    Node *res = pop_locked();
+    consumer_lock_.clear(std::memory_order_release);
+    if (res)
+      size_.fetch_sub(1, std::memory_order_relaxed);
+    return res;
+  }
+
+  // Number of nodes in the queue including those being pushed right now.
+  std::size_t size() const noexcept {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+private:
+  void link(Node *first, Node *last) noexcept {
+    last->next.store(nullptr, std::memory_order_relaxed);
+    Node *prev = head_.exchange(last, std::memory_order_acq_rel);
+    prev->next.store(first, std::memory_order_release);
+  }
+
+  Node *pop_locked() noexcept {
+    Node *tail = tail_;
+    Node *next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (!next)
+        return nullptr;
+      tail_ = next;
+      tail = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+    if (next) {
+      tail_ = next;
+      return tail;
+    }
+    // Some producer has swapped the head but not linked the node yet
+    if (tail != head_.load(std::memory_order_acquire))
+      return nullptr;
+    link(&stub_, &stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+      tail_ = next;
+      return tail;
+    }
+    return nullptr;
+  }
+
+private:
+  std::atomic<Node *> head_;
+  std::atomic<std::size_t> size_{0};
+  // Keep producers and consumers data on separate cache lines
+  char padding_[64 - sizeof(std::atomic<Node *>) -
+                sizeof(std::atomic<std::size_t>)];
+  std::atomic_flag consumer_lock_ = ATOMIC_FLAG_INIT;
+  Node *tail_;
+  Node stub_;
+};
+
+} // namespace detail
+} // namespace cxx14_v1
+} // namespace portable_concurrency
@@ -1,8 +1,8 @@
 #pragma once
 
-#include <condition_variable>
+#include <atomic>
 #include <cstddef>
-#include <mutex>
+#include <cstdint>
 
 namespace portable_concurrency {
 inline namespace cxx14_v1 {
@@ -16,10 +16,15 @@ inline namespace cxx14_v1 {
  * Threads may block on the latch until the counter is decremented to zero.
  * There is no possibility to increase or reset the counter, which makes the
  * latch a single-use barrier.
+ *
+ * Counter is decremented without locking and threads blocked on the latch are
+ * only woken up when it reaches zero. Destructor blocks until all of the
+ * threads woken up by the latch leave `wait` or `count_down_and_wait`.
  */
 class latch {
 public:
-  explicit latch(ptrdiff_t count) : counter_(count) {}
+  explicit latch(ptrdiff_t count)
+      : counter_(count), readiness_{count == 0 ? ready : not_ready} {}
 
   latch(const latch &) = delete;
   latch &operator=(const latch &) = delete;
@@ -32,10 +37,13 @@ public:
   void wait() const;
 
 private:
-  ptrdiff_t counter_;
-  mutable unsigned waiters_ = 0;
-  mutable std::mutex mutex_;
-  mutable std::condition_variable cv_;
+  void block() const;
+
+  enum : std::uint32_t { not_ready, has_waiters, ready };
+
+  std::atomic<ptrdiff_t> counter_;
+  mutable std::atomic<std::uint32_t> readiness_;
+  mutable std::atomic<std::uint32_t> waiters_{0};
 };
 
 } // namespace cxx14_v1
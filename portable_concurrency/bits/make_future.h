@@ -18,28 +18,64 @@ template <typename T> struct decay_for_future<std::reference_wrapper<T>> {
 template <typename T>
 using decay_for_future_t = typename decay_for_future<T>::type;
 
+template <typename T, typename U>
+future<T> make_ready_future(std::true_type, U &&value) {
+  return ready_value_t<T>{in_place_index_t<1>{}, std::forward<U>(value)};
+}
+
+template <typename T, typename U>
+future<T> make_ready_future(std::false_type, U &&value) {
+  auto promise_and_future = make_promise<T>();
+  promise_and_future.first.set_value(std::forward<U>(value));
+  return std::move(promise_and_future.second);
+}
+
+template <typename T>
+future<T> make_exceptional_future(std::true_type, std::exception_ptr error) {
+  return ready_value_t<T>{in_place_index_t<2>{}, std::move(error)};
+}
+
+template <typename T>
+future<T> make_exceptional_future(std::false_type, std::exception_ptr error) {
+  auto promise_and_future = make_promise<T>();
+  promise_and_future.first.set_exception(std::move(error));
+  return std::move(promise_and_future.second);
+}
+
 } // namespace detail
 
+/**
+ * @ingroup future_hdr
+ *
+ * Creates ready future object holding the @a value. If the value is of void,
+ * reference or scalar type it is stored directly in the future object and no
+ * shared state is allocated unless one is required later, e.g. by
+ * `future::share`.
+ */
 template <typename T>
 future<detail::decay_for_future_t<T>> make_ready_future(T &&value) {
-  auto promise_and_future = make_promise<detail::decay_for_future_t<T>>();
-  promise_and_future.first.set_value(std::forward<T>(value));
-  return std::move(promise_and_future.second);
+  using value_type = detail::decay_for_future_t<T>;
+  return detail::make_ready_future<value_type>(
+      detail::stored_inline<value_type>{}, std::forward<T>(value));
 }
 
 future<void> make_ready_future();
 
+/**
+ * @ingroup future_hdr
+ *
+ * Creates ready future object holding the @a error. For the futures of void,
+ * reference or scalar types shared state is not allocated unless one is
+ * required later.
+ */
 template <typename T>
 future<T> make_exceptional_future(std::exception_ptr error) {
-  promise<T> promise;
-  promise.set_exception(error);
-  return promise.get_future();
+  return detail::make_exceptional_future<T>(detail::stored_inline<T>{},
+                                            std::move(error));
 }
 
 template <typename T, typename E> future<T> make_exceptional_future(E error) {
-  promise<T> promise;
-  promise.set_exception(std::make_exception_ptr(error));
-  return promise.get_future();
+  return make_exceptional_future<T>(std::make_exception_ptr(error));
 }
 
 } // namespace cxx14_v1
@@ -0,0 +1,177 @@
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+#include "memory_pool.h"
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+
+namespace {
+
+constexpr std::size_t size_class_granularity = 16;
+constexpr std::size_t size_classes_count = 32;
+constexpr std::size_t max_pooled_size =
+    size_class_granularity * size_classes_count;
+// Limit of blocks of each size class cached by single thread
+constexpr std::size_t max_cached_blocks = 64;
+// Number of blocks moved between the thread cache and the central list at once
+constexpr std::size_t transfer_batch = max_cached_blocks / 2;
+// Limit of batches of each size class kept by the central list
+constexpr std::size_t max_central_batches = 32;
+
+std::atomic<bool> pool_enabled{false};
+
+struct free_block {
+  free_block *next;
+  // Link between the batches of the central list. Valid for the first block of
+  // the batch only.
+  free_block *next_batch;
+};
+
+// Blocks released by one thread are passed to the others through the central
+// list. Shared states are often created by one thread and released by another
+// one so without it producer thread would never get its blocks back.
+struct central_list {
+  std::mutex mutex;
+  free_block *batches = nullptr;
+  std::size_t count = 0;
+};
+
+// Never destroyed so that it remains accessible to the threads exiting after
+// static objects destruction.
+central_list &central_list_of(std::size_t idx) {
+  static central_list *lists = new central_list[size_classes_count];
+  return lists[idx];
+}
+
+// Trivially destructible so that it remains accessible while other thread local
+// objects are destroyed.
+struct thread_cache {
+  free_block *blocks[size_classes_count];
+  std::size_t counts[size_classes_count];
+  bool exiting;
+};
+
+thread_local thread_cache cache = {};
+
+void delete_blocks(free_block *block) noexcept {
+  while (block) {
+    auto *next = block->next;
+    ::operator delete(block);
+    block = next;
+  }
+}
+
+// Moves `transfer_batch` blocks from the thread cache to the central list
+void release_batch(std::size_t idx) {
+  free_block *head = cache.blocks[idx];
+  free_block *tail = head;
+  for (std::size_t i = 1; i < transfer_batch; ++i)
+    tail = tail->next;
+  cache.blocks[idx] = tail->next;
+  cache.counts[idx] -= transfer_batch;
+  tail->next = nullptr;
+
+  auto &list = central_list_of(idx);
+  {
+    std::lock_guard<std::mutex> lock{list.mutex};
+    if (list.count < max_central_batches) {
+      head->next_batch = list.batches;
+      list.batches = head;
+      ++list.count;
+      return;
+    }
+  }
+  delete_blocks(head);
+}
+
+// Refills empty thread cache with the batch from the central list
+void acquire_batch(std::size_t idx) {
+  auto &list = central_list_of(idx);
+  std::lock_guard<std::mutex> lock{list.mutex};
+  if (!list.batches)
+    return;
+  cache.blocks[idx] = list.batches;
+  cache.counts[idx] = transfer_batch;
+  list.batches = list.batches->next_batch;
+  --list.count;
+}
+
+struct thread_cache_cleaner {
+  ~thread_cache_cleaner() {
+    cache.exiting = true;
+    for (std::size_t i = 0; i < size_classes_count; ++i) {
+      while (cache.counts[i] >= transfer_batch)
+        release_batch(i);
+      delete_blocks(cache.blocks[i]);
+      cache.blocks[i] = nullptr;
+      cache.counts[i] = 0;
+    }
+  }
+};
+
+// Registers cache cleanup on the thread exit
+void register_cleaner() {
+  static thread_local thread_cache_cleaner cleaner;
+  (void)cleaner;
+}
+
+std::size_t size_class(std::size_t size) noexcept {
+  return (size + size_class_granularity - 1) / size_class_granularity - 1;
+}
+
+} // namespace
+
+void set_memory_pool_enabled(bool enabled) noexcept {
+  pool_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool memory_pool_enabled() noexcept {
+  return pool_enabled.load(std::memory_order_relaxed);
+}
+
+namespace detail {
+
+// All of the blocks of the same size class are allocated with the same size
+// regardless of the pool state so they can always be released with global
+// operator delete.
+void *pool_allocate(std::size_t size) {
+  if (size == 0 || size > max_pooled_size)
+    return ::operator new(size);
+  const std::size_t idx = size_class(size);
+  if (memory_pool_enabled() && !cache.exiting) {
+    if (!cache.blocks[idx]) {
+      register_cleaner();
+      acquire_batch(idx);
+    }
+    if (auto *block = cache.blocks[idx]) {
+      cache.blocks[idx] = block->next;
+      --cache.counts[idx];
+      return block;
+    }
+  }
+  return ::operator new((idx + 1) * size_class_granularity);
+}
+
+void pool_deallocate(void *ptr, std::size_t size) noexcept {
+  if (!ptr)
+    return;
+  if (size == 0 || size > max_pooled_size || !memory_pool_enabled() ||
+      cache.exiting) {
+    ::operator delete(ptr);
+    return;
+  }
+  const std::size_t idx = size_class(size);
+  register_cleaner();
+  if (cache.counts[idx] == max_cached_blocks)
+    release_batch(idx);
+  cache.blocks[idx] = new (ptr) free_block{cache.blocks[idx], nullptr};
+  ++cache.counts[idx];
+}
+
+} // namespace detail
+
+} // namespace cxx14_v1
+} // namespace portable_concurrency
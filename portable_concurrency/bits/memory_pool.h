@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+
+/**
+ * @headerfile portable_concurrency/future
+ * @ingroup future_hdr
+ *
+ * Enables or disables the thread caching memory pool used by the library for
+ * shared states, continuation stack nodes and function objects which do not
+ * fit the small buffer of `unique_function`. Pool is disabled by default.
+ *
+ * Memory blocks up to 512 bytes are rounded up to the size class multiple of
+ * 16 bytes. Released blocks are cached by the releasing thread and reused by
+ * subsequent allocations of the same size class on that thread so that steady
+ * state future chains don't call global `operator new` at all. Number of
+ * blocks cached per thread is limited. Excess blocks are moved in batches to
+ * the central list shared by all threads where threads with an empty cache
+ * take them from. This way blocks released by the consumer of the value get
+ * back to the thread producing it. Cached blocks are moved to the central list
+ * when the thread exits. Blocks which don't fit the limited central list are
+ * returned to the global `operator delete`.
+ *
+ * This function can be called at any time. Blocks allocated while the pool was
+ * enabled can be safely released after it was disabled and vice versa.
+ */
+void set_memory_pool_enabled(bool enabled) noexcept;
+
+/**
+ * @headerfile portable_concurrency/future
+ * @ingroup future_hdr
+ *
+ * Checks if the memory pool is enabled with @ref set_memory_pool_enabled.
+ */
+bool memory_pool_enabled() noexcept;
+
+namespace detail {
+
+void *pool_allocate(std::size_t size);
+void pool_deallocate(void *ptr, std::size_t size) noexcept;
+
+// Pool blocks only have the alignment guaranteed by the global operator new
+// so over-aligned objects are allocated with the aligned one directly.
+inline void *pool_allocate(std::size_t size, std::size_t alignment) {
+#if defined(__cpp_aligned_new)
+  if (alignment > alignof(std::max_align_t))
+    return ::operator new(size, std::align_val_t{alignment});
+#endif
+  (void)alignment;
+  return pool_allocate(size);
+}
+
+inline void pool_deallocate(void *ptr, std::size_t size,
+                            std::size_t alignment) noexcept {
+#if defined(__cpp_aligned_new)
+  if (alignment > alignof(std::max_align_t)) {
+    ::operator delete(ptr, std::align_val_t{alignment});
+    return;
+  }
+#endif
+  (void)alignment;
+  pool_deallocate(ptr, size);
+}
+
+/**
+ * @internal
+ *
+ * Stateless allocator taking memory from the library memory pool.
+ */
+template <typename T> class pool_allocator {
+public:
+  using value_type = T;
+
+  pool_allocator() noexcept = default;
+  template <typename U> pool_allocator(const pool_allocator<U> &) noexcept {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(pool_allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T *ptr, std::size_t n) noexcept {
+    pool_deallocate(ptr, n * sizeof(T), alignof(T));
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const pool_allocator<T> &, const pool_allocator<U> &) noexcept {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const pool_allocator<T> &, const pool_allocator<U> &) noexcept {
+  return false;
+}
+
+template <typename T> struct pool_deleter {
+  void operator()(T *ptr) noexcept {
+    ptr->~T();
+    pool_deallocate(ptr, sizeof(T), alignof(T));
+  }
+};
+
+template <typename T>
+using pool_unique_ptr = std::unique_ptr<T, pool_deleter<T>>;
+
+template <typename T, typename... A> pool_unique_ptr<T> make_pooled(A &&...a) {
+  void *mem = pool_allocate(sizeof(T), alignof(T));
+  try {
+    return pool_unique_ptr<T>{new (mem) T(std::forward<A>(a)...)};
+  } catch (...) {
+    pool_deallocate(mem, sizeof(T), alignof(T));
+    throw;
+  }
+}
+
+} // namespace detail
+
+} // namespace cxx14_v1
+} // namespace portable_concurrency
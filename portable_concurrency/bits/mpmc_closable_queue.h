@@ -0,0 +1,163 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "event_count.h"
+#include "mpmc_queue.h"
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+
+/**
+ * @headerfile portable_concurrency/closable_queue
+ * @ingroup closable_queue
+ *
+ * Multi producer multi consumer FIFO channel which can be closed by any party
+ * to signal that no more values are going to be pushed.
+ *
+ * Values are stored in a lock-free ring buffer. Threads only touch the mutex
+ * and the condition variable when there is a consumer waiting for a value or a
+ * producer waiting for a free slot in the bounded queue.
+ *
+ * Value type must be nothrow move constructible and nothrow move assignable.
+ */
+template <typename T> class closable_queue {
+public:
+  /**
+   * Creates unbounded queue. Values which do not fit into the lock-free ring
+   * are stored in the mutex protected list until the consumers catch up.
+   */
+  closable_queue() : queue_{1024, true} {}
+
+  /**
+   * Creates bounded queue which can hold at least `capacity` values. The actual
+   * capacity is rounded up to the power of two.
+   */
+  explicit closable_queue(std::size_t capacity) : queue_{capacity, false} {}
+
+  closable_queue(const closable_queue &) = delete;
+  closable_queue &operator=(const closable_queue &) = delete;
+
+  /**
+   * Pushes the value to the queue blocking while the bounded queue is full.
+   *
+   * Returns false and leaves the value intact if the queue is closed.
+   */
+  bool push(T &&val) {
+    producer_scope scope{*this};
+    if (!scope.entered)
+      return false;
+    bool pushed = queue_.try_push(std::move(val));
+    while (!pushed) {
+      const auto key = not_full_.prepare_wait();
+      pushed = queue_.try_push(std::move(val));
+      if (pushed || is_closed()) {
+        not_full_.cancel_wait();
+        break;
+      }
+      not_full_.commit_wait(key);
+      pushed = queue_.try_push(std::move(val));
+    }
+    if (pushed)
+      not_empty_.notify_one();
+    return pushed;
+  }
+
+  /**
+   * Pushes the value to the queue if it is neither full nor closed.
+   *
+   * Returns false and leaves the value intact otherwise.
+   */
+  bool try_push(T &&val) {
+    producer_scope scope{*this};
+    if (!scope.entered || !queue_.try_push(std::move(val)))
+      return false;
+    not_empty_.notify_one();
+    return true;
+  }
+
+  /**
+   * Moves the oldest value from the queue to `dest` blocking while the queue is
+   * empty.
+   *
+   * Returns false if the queue is closed and all of the values pushed before
+   * closing are already consumed.
+   */
+  bool pop(T &dest) {
+    for (;;) {
+      if (try_pop(dest))
+        return true;
+      const auto key = not_empty_.prepare_wait();
+      const auto state = state_.load(std::memory_order_acquire);
+      if (try_pop(dest)) {
+        not_empty_.cancel_wait();
+        return true;
+      }
+      // Closed and there are no unfinished pushes
+      if (state == closed_bit) {
+        not_empty_.cancel_wait();
+        return false;
+      }
+      not_empty_.commit_wait(key);
+    }
+  }
+
+  /**
+   * Moves the oldest value from the queue to `dest` if the queue is not empty.
+   */
+  bool try_pop(T &dest) {
+    if (!queue_.try_pop(dest))
+      return false;
+    if (!queue_.unbounded())
+      not_full_.notify_one();
+    return true;
+  }
+
+  /**
+   * Closes the queue. All subsequent pushes fail while pops continue to
+   * return values pushed before closing.
+   */
+  void close() noexcept {
+    state_.fetch_or(closed_bit, std::memory_order_acq_rel);
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+  bool is_closed() const noexcept {
+    return (state_.load(std::memory_order_acquire) & closed_bit) != 0;
+  }
+
+private:
+  // Lowest bit of the state is the closed flag, the rest is the number of
+  // pushes in progress.
+  static constexpr std::size_t closed_bit = 1;
+  static constexpr std::size_t producer_inc = 2;
+
+  struct producer_scope {
+    explicit producer_scope(closable_queue &queue) noexcept : queue{queue} {
+      entered = (queue.state_.fetch_add(producer_inc,
+                                        std::memory_order_acquire) &
+                 closed_bit) == 0;
+    }
+
+    ~producer_scope() {
+      const auto prev =
+          queue.state_.fetch_sub(producer_inc, std::memory_order_acq_rel);
+      // Consumers may wait for the last push to finish after closing
+      if (prev == (closed_bit | producer_inc))
+        queue.not_empty_.notify_all();
+    }
+
+    closable_queue &queue;
+    bool entered;
+  };
+
+  detail::mpmc_queue<T> queue_;
+  std::atomic<std::size_t> state_{0};
+  detail::event_count not_empty_;
+  detail::event_count not_full_;
+};
+
+} // namespace cxx14_v1
+} // namespace portable_concurrency
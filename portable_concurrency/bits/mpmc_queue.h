@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+namespace detail {
+
+/**
+ * @internal
+ *
+ * Lock-free multi producer multi consumer FIFO queue based on the Dmitry
+ * Vyukov's bounded ring buffer. Every slot of the ring carries a sequence
+ * number telling if it is ready to be written or to be read on the current lap
+ * over the ring. Producers and consumers only contend on their own position
+ * counters.
+ *
+ * Bounded queue rejects pushes while the ring is full. Unbounded queue moves
+ * extra items to the mutex protected overflow list which stays in use until all
+ * of the items from it are consumed. FIFO order of items pushed by any single
+ * thread is preserved in both modes.
+ *
+ * Neither push nor pop ever blocks waiting for the queue state change. Blocking
+ * operations can be built on top of it with @ref event_count.
+ */
+template <typename T> class mpmc_queue {
+  static_assert(std::is_nothrow_move_constructible<T>::value &&
+                    std::is_nothrow_move_assignable<T>::value,
+                "mpmc_queue requires nothrow movable items");
+
+public:
+  mpmc_queue(std::size_t capacity, bool unbounded)
+      : mask_{round_up_pow2(capacity) - 1}, cells_{new cell[mask_ + 1]},
+        unbounded_{unbounded} {
+    for (std::size_t i = 0; i <= mask_; ++i)
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  ~mpmc_queue() {
+    const std::size_t end = enqueue_pos_.load(std::memory_order_relaxed);
+    for (std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+         pos != end; ++pos)
+      cells_[pos & mask_].item()->~T();
+  }
+
+  mpmc_queue(const mpmc_queue &) = delete;
+  mpmc_queue &operator=(const mpmc_queue &) = delete;
+
+  // Returns false if bounded queue is full. The value is only moved from if
+  // the push succeeds.
+  bool try_push(T &&val) {
+    if (!overflowed_.load(std::memory_order_acquire) && ring_push(val))
+      return true;
+    if (!unbounded_)
+      return false;
+    std::lock_guard<std::mutex> lock{overflow_mutex_};
+    if (overflow_.empty() && ring_push(val))
+      return true;
+    overflow_.push_back(std::move(val));
+    overflowed_.store(true, std::memory_order_release);
+    return true;
+  }
+
+  // Returns false if the queue is empty or the only items in it are still
+  // being pushed.
+  bool try_pop(T &dest) {
+    if (ring_pop(dest))
+      return true;
+    if (!overflowed_.load(std::memory_order_acquire))
+      return false;
+    std::lock_guard<std::mutex> lock{overflow_mutex_};
+    // Ring may be refilled by producers which have not noticed the overflow
+    if (ring_pop(dest))
+      return true;
+    if (overflow_.empty())
+      return false;
+    dest = std::move(overflow_.front());
+    overflow_.pop_front();
+    if (overflow_.empty())
+      overflowed_.store(false, std::memory_order_release);
+    return true;
+  }
+
+  bool unbounded() const noexcept { return unbounded_; }
+
+  // Approximate number of items in the queue including the overflow list.
+  std::size_t size() {
+    const std::size_t dequeued = dequeue_pos_.load(std::memory_order_relaxed);
+    const std::size_t enqueued = enqueue_pos_.load(std::memory_order_relaxed);
+    std::size_t res = distance(dequeued, enqueued) > 0
+                          ? static_cast<std::size_t>(enqueued - dequeued)
+                          : 0;
+    if (overflowed_.load(std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> lock{overflow_mutex_};
+      res += overflow_.size();
+    }
+    return res;
+  }
+
+private:
+  struct cell {
+    T *item() noexcept { return reinterpret_cast<T *>(&storage); }
+
+    std::atomic<std::size_t> sequence;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  };
+
+  static std::size_t round_up_pow2(std::size_t val) noexcept {
+    std::size_t res = 2;
+    while (res < val)
+      res <<= 1;
+    return res;
+  }
+
+  static std::intptr_t distance(std::size_t from, std::size_t to) noexcept {
+    return static_cast<std::intptr_t>(to - from);
+  }
+
+  bool ring_push(T &val) noexcept {
+    std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell &c = cells_[pos & mask_];
+      const std::size_t seq = c.sequence.load(std::memory_order_acquire);
+      const std::intptr_t diff = distance(pos, seq);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed,
+                                               std::memory_order_relaxed)) {
+          ::new (static_cast<void *>(c.item())) T(std::move(val));
+          c.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        // Slot is not consumed on the previous lap yet: the ring is full
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool ring_pop(T &dest) noexcept {
+    std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell &c = cells_[pos & mask_];
+      const std::size_t seq = c.sequence.load(std::memory_order_acquire);
+      const std::intptr_t diff = distance(pos + 1, seq);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed,
+                                               std::memory_order_relaxed)) {
+          T *item = c.item();
+          dest = std::move(*item);
+          item->~T();
+          c.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        // Slot is not written on the current lap yet: the ring is empty
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+private:
+  const std::size_t mask_;
+  const std::unique_ptr<cell[]> cells_;
+  const bool unbounded_;
+  // Keep producers and consumers positions on separate cache lines
+  char padding0_[64];
+  std::atomic<std::size_t> enqueue_pos_{0};
+  char padding1_[64 - sizeof(std::atomic<std::size_t>)];
+  std::atomic<std::size_t> dequeue_pos_{0};
+  char padding2_[64 - sizeof(std::atomic<std::size_t>)];
+
+  std::atomic<bool> overflowed_{false};
+  std::mutex overflow_mutex_;
+  std::deque<T> overflow_;
+};
+
+} // namespace detail
+} // namespace cxx14_v1
+} // namespace portable_concurrency
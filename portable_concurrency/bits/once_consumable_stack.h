@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <memory>
+#include <type_traits>
 
 namespace portable_concurrency {
 inline namespace cxx14_v1 {
@@ -59,6 +60,54 @@ forward_list<T> allocate_list_node(T &&val, const Alloc &alloc) {
   return forward_list<T>{result, forward_list_deleter<T>{}};
 }
 
+/**
+ * @internal
+ *
+ * Items taken from the once_consumable_stack. Item stored inside of the stack
+ * object itself is moved out of it so that the stack can be destroyed while
+ * consumed items are processed.
+ */
+template <typename T> class consumed_items {
+public:
+  class iterator {
+  public:
+    iterator() noexcept = default;
+    iterator(forward_list_node<T> *node, T *inline_item) noexcept
+        : node_{node}, inline_item_{inline_item} {}
+
+    iterator &operator++() noexcept {
+      if (node_)
+        node_ = node_->next;
+      else
+        inline_item_ = nullptr;
+      return *this;
+    }
+
+    T &operator*() const noexcept { return node_ ? node_->val : *inline_item_; }
+
+    bool operator==(const iterator &rhs) const noexcept {
+      return node_ == rhs.node_ && inline_item_ == rhs.inline_item_;
+    }
+
+    bool operator!=(const iterator &rhs) const noexcept {
+      return !(*this == rhs);
+    }
+
+  private:
+    forward_list_node<T> *node_ = nullptr;
+    T *inline_item_ = nullptr;
+  };
+
+  iterator begin() noexcept {
+    return {list.get(), has_inline_item ? &inline_item : nullptr};
+  }
+  iterator end() noexcept { return {}; }
+
+  forward_list<T> list;
+  T inline_item;
+  bool has_inline_item = false;
+};
+
 /**
  * @internal
  *
@@ -73,6 +122,10 @@ forward_list<T> allocate_list_node(T &&val, const Alloc &alloc) {
  *
  * Last requrement allows consumer atomically trasfer data to producers with a
  * single operation of stack consumption.
+ *
+ * The first pushed item is stored inside of the stack object without separate
+ * node allocation. Only subsequent items are allocated. `T` must be default
+ * constructible.
  */
 template <typename T> class once_consumable_stack {
 public:
@@ -93,7 +146,9 @@ public:
   bool push(T &val);
 
   template <typename Alloc> bool push(T &val, const Alloc &alloc) {
-    forward_list<T> node = allocate_list_node(std::move(val), alloc);
+    forward_list<T> node = claim_inline_node()
+                               ? make_inline_node(std::move(val))
+                               : allocate_list_node(std::move(val), alloc);
     if (push(node))
       return true;
     val = std::move(node->val);
@@ -107,6 +162,13 @@ public:
    */
   bool is_consumed() const noexcept;
 
+  /**
+   * Checks if nothing was pushed to the stack and it is not @em consumed yet.
+   *
+   * @note Can be called from multiple threads.
+   */
+  bool empty() const noexcept;
+
   /**
    * Consumes the stack and switch it into @em consumed state. Running this
    * function concurrently with any other function in this class (excpet
@@ -115,9 +177,21 @@ public:
    * @note Must be called from a single thread. Must not be called twice on a
    * same queue.
    */
-  forward_list<T> consume() noexcept;
+  consumed_items<T> consume() noexcept;
 
 private:
+  struct inline_node final : forward_list_node<T> {
+    using forward_list_node<T>::forward_list_node;
+
+    void deallocate_self() override { this->~inline_node(); }
+  };
+
+  bool claim_inline_node() noexcept {
+    return !inline_claimed_.load(std::memory_order_relaxed) &&
+           !inline_claimed_.exchange(true, std::memory_order_relaxed);
+  }
+  forward_list<T> make_inline_node(T &&val) noexcept;
+
   // Return address of some valid object which can not alias with
   // forward_list_node<T> instances. Can be used as marker in pointer
   // compariaions but must never be dereferenced.
@@ -126,7 +200,12 @@ private:
   bool push(forward_list<T> &node) noexcept;
 
 private:
+  // Must be the first member: address of the stack object is used as consumed
+  // marker and must not alias with the inline node.
   std::atomic<forward_list_node<T> *> head_{nullptr};
+  std::atomic<bool> inline_claimed_{false};
+  typename std::aligned_storage<sizeof(inline_node), alignof(inline_node)>::type
+      inline_storage_;
 };
 
 } // namespace detail
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <cassert>
+#include <new>
 #include <type_traits>
 #include <utility>
 
+#include "memory_pool.h"
 #include "once_consumable_stack.h"
 
 namespace portable_concurrency {
@@ -21,41 +23,6 @@ void forward_list_deleter<T>::operator()(forward_list_node<T> *head) noexcept {
   }
 }
 
-template <typename T> class forward_list_iterator {
-public:
-  forward_list_iterator() noexcept = default;
-  forward_list_iterator(forward_list<T> &list) noexcept : node_(list.get()) {}
-
-  forward_list_iterator operator++() noexcept {
-    if (!node_)
-      return *this;
-    node_ = node_->next;
-    return *this;
-  }
-
-  T &operator*() noexcept { return node_->val; }
-
-  bool operator==(const forward_list_iterator &rhs) const noexcept {
-    return node_ == rhs.node_;
-  }
-
-  bool operator!=(const forward_list_iterator &rhs) const noexcept {
-    return node_ != rhs.node_;
-  }
-
-private:
-  forward_list_node<T> *node_ = nullptr;
-};
-
-template <typename T>
-forward_list_iterator<T> begin(forward_list<T> &list) noexcept {
-  return {list};
-}
-
-template <typename T> forward_list_iterator<T> end(forward_list<T> &) noexcept {
-  return {};
-}
-
 template <typename T>
 once_consumable_stack<T>::once_consumable_stack() noexcept {}
 
@@ -69,7 +36,7 @@ template <typename T> once_consumable_stack<T>::~once_consumable_stack() {
 }
 
 template <typename T> bool once_consumable_stack<T>::push(T &val) {
-  return push(val, std::allocator<T>{});
+  return push(val, pool_allocator<T>{});
 }
 
 template <typename T>
@@ -95,13 +62,39 @@ bool once_consumable_stack<T>::is_consumed() const noexcept {
   return head_.load(std::memory_order_acquire) == consumed_marker();
 }
 
+template <typename T> bool once_consumable_stack<T>::empty() const noexcept {
+  return head_.load(std::memory_order_acquire) == nullptr;
+}
+
 template <typename T>
-forward_list<T> once_consumable_stack<T>::consume() noexcept {
+forward_list<T> once_consumable_stack<T>::make_inline_node(T &&val) noexcept {
+  static_assert(std::is_nothrow_move_constructible<T>::value,
+                "T must be nothrow move constructible");
+  return forward_list<T>{new (&inline_storage_) inline_node{std::move(val)},
+                         forward_list_deleter<T>{}};
+}
+
+template <typename T>
+consumed_items<T> once_consumable_stack<T>::consume() noexcept {
+  consumed_items<T> res;
   auto *curr_head =
       head_.exchange(consumed_marker(), std::memory_order_acq_rel);
   if (curr_head == consumed_marker())
-    return {nullptr, forward_list_deleter<T>{}};
-  return forward_list<T>{curr_head, forward_list_deleter<T>{}};
+    return res;
+  if (inline_claimed_.load(std::memory_order_relaxed)) {
+    auto *inline_item = reinterpret_cast<inline_node *>(&inline_storage_);
+    for (auto **link = &curr_head; *link; link = &(*link)->next) {
+      if (*link != inline_item)
+        continue;
+      *link = inline_item->next;
+      res.inline_item = std::move(inline_item->val);
+      res.has_inline_item = true;
+      inline_item->inline_node::~inline_node();
+      break;
+    }
+  }
+  res.list.reset(curr_head);
+  return res;
 }
 
 template <typename T>
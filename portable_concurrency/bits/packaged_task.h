@@ -14,40 +14,40 @@ inline namespace cxx14_v1 {
 
 namespace detail {
 
-template <typename R, typename... A> struct packaged_task_state {
-  virtual ~packaged_task_state() = default;
-
-  virtual void run(std::shared_ptr<shared_state<R>> &state, A &&...) = 0;
-  virtual future_state<R> *get_future_state() = 0;
-  virtual shared_state<R> *get_promise_state() = 0;
+template <typename R, typename... A>
+class packaged_task_state : public shared_state<R> {
+public:
+  virtual void run(state_ptr<shared_state<R>> &self, A &&...) = 0;
   virtual void abandon() = 0;
 };
 
 template <typename F, typename R, typename... A>
-struct task_state final : packaged_task_state<R, A...> {
+class task_state : public packaged_task_state<R, A...> {
+public:
   task_state(F &&f) : func(detail::in_place_index_t<1>{}, std::forward<F>(f)) {}
 
-  void run(std::shared_ptr<shared_state<R>> &state_ptr, A &&...a) override {
-    assert(state_ptr.get() == &state);
+  void run(state_ptr<shared_state<R>> &self, A &&...a) override {
+    assert(self.get() == this);
     if (func.state() == 0)
       throw_already_satisfied();
     scope_either_cleaner<decltype(func)> claner{func};
     ::portable_concurrency::cxx14_v1::detail::set_state_value(
-        state_ptr, func.get(detail::in_place_index_t<1>{}),
-        std::forward<A>(a)...);
+        self, func.get(detail::in_place_index_t<1>{}), std::forward<A>(a)...);
   }
 
-  future_state<R> *get_future_state() override { return &state; }
-
-  shared_state<R> *get_promise_state() override { return &state; }
-
   void abandon() override {
     func.clean();
-    state.abandon();
+    shared_state<R>::abandon();
+  }
+
+private:
+  void dispose() noexcept override {
+    func.clean();
+    shared_state<R>::dispose();
   }
 
+private:
   detail::either<detail::monostate, std::decay_t<F>> func;
-  shared_state<R> state;
 };
 
 } // namespace detail
@@ -55,6 +55,7 @@ struct task_state final : packaged_task_state<R, A...> {
 template <typename R, typename... A> class packaged_task<R(A...)> {
 private:
   using result_type = typename detail::add_future_t<R>::value_type;
+  using state_type = detail::packaged_task_state<result_type, A...>;
 
 public:
   packaged_task() noexcept = default;
@@ -66,13 +67,25 @@ public:
   template <typename F>
   explicit packaged_task(F &&f)
       : state_{detail::in_place_index_t<1>{},
-               std::make_shared<detail::task_state<F, result_type, A...>>(
+               detail::make_state<detail::task_state<F, result_type, A...>>(
                    std::forward<F>(f))} {
     static_assert(
         std::is_convertible<detail::invoke_result_t<F, A...>, R>::value,
         "F must be Callable with signature R(A...)");
   }
 
+  // Shared state is allocated with the `allocator` [EXTENSION]
+  template <typename Alloc, typename F>
+  packaged_task(std::allocator_arg_t, const Alloc &allocator, F &&f)
+      : state_{detail::in_place_index_t<1>{},
+               detail::allocate_state<
+                   detail::task_state<F, result_type, A...>>(
+                   allocator, std::forward<F>(f))} {
+    static_assert(
+        std::is_convertible<detail::invoke_result_t<F, A...>, R>::value,
+        "F must be Callable with signature R(A...)");
+  }
+
   packaged_task(const packaged_task &) = delete;
   packaged_task(packaged_task &&) noexcept = default;
 
@@ -93,38 +106,33 @@ public:
       detail::throw_already_retrieved();
     auto state = get_state();
     state_.emplace(detail::in_place_index_t<2>{}, state);
-    return {std::shared_ptr<detail::future_state<result_type>>{
-        state, state->get_future_state()}};
+    return {detail::state_ptr<detail::future_state<result_type>>{
+        std::move(state)}};
   }
 
   void operator()(A... a) {
     if (auto state = get_state()) {
-      std::shared_ptr<detail::shared_state<result_type>> state_ptr{
-          state, state->get_promise_state()};
-      state->run(state_ptr, std::forward<A>(a)...);
+      auto &task = *state;
+      detail::state_ptr<detail::shared_state<result_type>> promise_state{
+          std::move(state)};
+      task.run(promise_state, std::forward<A>(a)...);
     }
   }
 
 private:
-  std::shared_ptr<detail::packaged_task_state<result_type, A...>>
-  get_state(bool throw_no_state = true) {
+  detail::state_ptr<state_type> get_state(bool throw_no_state = true) {
     struct {
-      std::shared_ptr<detail::packaged_task_state<result_type, A...>>
-      operator()(detail::monostate) {
+      detail::state_ptr<state_type> operator()(detail::monostate) {
         if (throw_no_state)
           detail::throw_no_state();
         return nullptr;
       }
-      std::shared_ptr<detail::packaged_task_state<result_type, A...>>
-      operator()(
-          const std::shared_ptr<detail::packaged_task_state<result_type, A...>>
-              &state) {
+      detail::state_ptr<state_type>
+      operator()(const detail::state_ptr<state_type> &state) {
         return state;
       }
-      std::shared_ptr<detail::packaged_task_state<result_type, A...>>
-      operator()(
-          const std::weak_ptr<detail::packaged_task_state<result_type, A...>>
-              &state) {
+      detail::state_ptr<state_type>
+      operator()(const detail::weak_state_ptr<state_type> &state) {
         return state.lock();
       }
 
@@ -134,10 +142,8 @@ private:
   }
 
 private:
-  detail::either<
-      detail::monostate,
-      std::shared_ptr<detail::packaged_task_state<result_type, A...>>,
-      std::weak_ptr<detail::packaged_task_state<result_type, A...>>>
+  detail::either<detail::monostate, detail::state_ptr<state_type>,
+                 detail::weak_state_ptr<state_type>>
       state_;
 };
 
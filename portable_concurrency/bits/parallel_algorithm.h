@@ -0,0 +1,448 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "either.h"
+#include "execution.h"
+#include "future.h"
+#include "invoke.h"
+#include "shared_state.h"
+
+#include <portable_concurrency/bits/config.h>
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+
+namespace detail {
+
+// Ranges of the parallel algorithms are either pairs of random access
+// iterators or pairs of integral indexes. Elements of the index range are the
+// indexes themselves.
+template <typename I>
+I range_at(const I &first, std::size_t idx, std::true_type) {
+  return static_cast<I>(first + static_cast<I>(idx));
+}
+
+template <typename I>
+decltype(auto) range_at(const I &first, std::size_t idx, std::false_type) {
+  using diff_t = typename std::iterator_traits<I>::difference_type;
+  return first[static_cast<diff_t>(idx)];
+}
+
+template <typename I>
+decltype(auto) range_at(const I &first, std::size_t idx) {
+  return range_at(first, idx, std::is_integral<I>{});
+}
+
+template <typename I>
+std::size_t range_size(const I &first, const I &last) noexcept {
+  return last > first ? static_cast<std::size_t>(last - first) : 0u;
+}
+
+// Number of times the root chunk is split in halves before anybody steals it.
+// Gives about 4 chunks per hardware thread.
+inline unsigned initial_split_depth() noexcept {
+  unsigned res = 2;
+  for (unsigned threads = std::thread::hardware_concurrency(); threads > 1;
+       threads = (threads + 1) / 2)
+    ++res;
+  return res;
+}
+
+// Additional splits allowed for the chunk executed by the thread other than
+// the one which posted it: stolen chunk indicates idle workers.
+constexpr unsigned steal_split_depth = 2;
+
+// Shared state of the future returned by the parallel algorithms. Completion
+// is tracked with a single counter of unfinished chunks rather than with a
+// future per chunk. The state keeps itself alive until all of the chunks are
+// either executed or destroyed. One extra completion is reserved for the
+// thread which starts the algorithm.
+template <typename T, typename E>
+class parallel_state : public shared_state<T> {
+public:
+  explicit parallel_state(const E &exec) : exec_(exec) {}
+
+  static void start(state_ptr<parallel_state> self) {
+    parallel_state &state = *self;
+    state.self_ = std::move(self);
+  }
+
+  template <typename Task> void spawn(Task &&task) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    post(exec_, std::forward<Task>(task));
+  }
+
+  void fail(std::exception_ptr error) noexcept {
+    if (!error_set_.test_and_set(std::memory_order_relaxed))
+      error_ = error;
+  }
+
+  void abandon() noexcept {
+    fail(make_broken_promise());
+    complete();
+  }
+
+  void complete() noexcept {
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+      return;
+    const auto self = std::move(self_);
+    try {
+      if (error_)
+        this->set_exception(error_);
+      else
+        set_result();
+    } catch (...) {
+      this->set_exception(std::current_exception());
+    }
+  }
+
+private:
+  virtual void set_result() = 0;
+
+  E exec_;
+  std::atomic<std::size_t> pending_{1};
+  std::atomic_flag error_set_ = ATOMIC_FLAG_INIT;
+  std::exception_ptr error_;
+  state_ptr<parallel_state> self_;
+};
+
+template <typename State> class chunk_task {
+public:
+  chunk_task(State *state, std::size_t begin, std::size_t end,
+             unsigned depth) noexcept
+      : state_(state), begin_(begin), end_(end), depth_(depth),
+        origin_(std::this_thread::get_id()) {}
+
+  chunk_task(chunk_task &&rhs) noexcept
+      : state_(std::exchange(rhs.state_, nullptr)), begin_(rhs.begin_),
+        end_(rhs.end_), depth_(rhs.depth_), origin_(rhs.origin_) {}
+  chunk_task &operator=(chunk_task &&) = delete;
+
+  ~chunk_task() {
+    if (state_)
+      state_->abandon();
+  }
+
+  void operator()() {
+    State *state = std::exchange(state_, nullptr);
+    unsigned depth = depth_;
+    if (origin_ != std::this_thread::get_id())
+      depth = std::max(depth, steal_split_depth);
+    state->run(begin_, end_, depth);
+  }
+
+private:
+  State *state_;
+  std::size_t begin_;
+  std::size_t end_;
+  unsigned depth_;
+  std::thread::id origin_;
+};
+
+// Splits the chunk in halves posting the right ones while the split budget
+// lasts and both halves are at least grain elements long and then processes
+// the rest sequentially.
+template <typename T, typename E>
+class parallel_range_state : public parallel_state<T, E> {
+public:
+  parallel_range_state(const E &exec, std::size_t grain)
+      : parallel_state<T, E>(exec), grain_(grain == 0 ? 1 : grain) {}
+
+  void run(std::size_t begin, std::size_t end, unsigned depth) noexcept {
+    try {
+      while (end - begin >= 2 * grain_ && depth > 0) {
+        const std::size_t mid = begin + (end - begin) / 2;
+        --depth;
+        this->spawn(chunk_task<parallel_range_state>{this, mid, end, depth});
+        end = mid;
+      }
+      process(begin, end);
+    } catch (...) {
+      this->fail(std::current_exception());
+    }
+    this->complete();
+  }
+
+private:
+  virtual void process(std::size_t begin, std::size_t end) = 0;
+
+  const std::size_t grain_;
+};
+
+template <typename Derived, typename... A>
+auto start_parallel(std::size_t size, A &&...a) {
+  auto state = make_state<Derived>(std::forward<A>(a)...);
+  auto *raw = state.get();
+  Derived::start(state);
+  future<typename Derived::value_type> res{std::move(state)};
+  struct submission_guard {
+    ~submission_guard() { state->complete(); }
+    Derived *state;
+  } guard{raw};
+  if (size != 0)
+    raw->spawn(chunk_task<Derived>{raw, 0, size, initial_split_depth()});
+  return res;
+}
+
+template <typename E, typename I, typename F>
+class for_each_state final : public parallel_range_state<void, E> {
+public:
+  using value_type = void;
+
+  for_each_state(const E &exec, std::size_t grain, I first, F &&func)
+      : parallel_range_state<void, E>(exec, grain), first_(first),
+        func_(std::forward<F>(func)) {}
+
+private:
+  void process(std::size_t begin, std::size_t end) override {
+    for (std::size_t i = begin; i != end; ++i)
+      ::portable_concurrency::cxx14_v1::detail::invoke(func_,
+                                                       range_at(first_, i));
+  }
+
+  void set_result() override { this->emplace(); }
+
+  const I first_;
+  std::decay_t<F> func_;
+};
+
+template <typename E, typename I, typename O, typename F>
+class transform_state final : public parallel_range_state<O, E> {
+public:
+  using value_type = O;
+
+  transform_state(const E &exec, std::size_t grain, I first, std::size_t size,
+                  O d_first, F &&func)
+      : parallel_range_state<O, E>(exec, grain), first_(first), size_(size),
+        d_first_(d_first), func_(std::forward<F>(func)) {}
+
+private:
+  void process(std::size_t begin, std::size_t end) override {
+    for (std::size_t i = begin; i != end; ++i) {
+      range_at(d_first_, i) = ::portable_concurrency::cxx14_v1::detail::invoke(
+          func_, range_at(first_, i));
+    }
+  }
+
+  void set_result() override {
+    using diff_t = typename std::iterator_traits<O>::difference_type;
+    this->emplace(d_first_ + static_cast<diff_t>(size_));
+  }
+
+  const I first_;
+  const std::size_t size_;
+  const O d_first_;
+  std::decay_t<F> func_;
+};
+
+template <typename E, typename I, typename T, typename F>
+class reduce_state final : public parallel_range_state<T, E> {
+public:
+  using value_type = T;
+
+  reduce_state(const E &exec, std::size_t grain, I first, T &&init, F &&func)
+      : parallel_range_state<T, E>(exec, grain), first_(first),
+        init_(std::move(init)), func_(std::forward<F>(func)) {}
+
+private:
+  void process(std::size_t begin, std::size_t end) override {
+    T partial = range_at(first_, begin);
+    for (std::size_t i = begin + 1; i != end; ++i)
+      partial = ::portable_concurrency::cxx14_v1::detail::invoke(
+          func_, std::move(partial), range_at(first_, i));
+
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (acc_.empty()) {
+      acc_.emplace(in_place_index_t<1>{}, std::move(partial));
+      return;
+    }
+    T &acc = acc_.get(in_place_index_t<1>{});
+    acc = ::portable_concurrency::cxx14_v1::detail::invoke(
+        func_, std::move(acc), std::move(partial));
+  }
+
+  void set_result() override {
+    if (acc_.empty()) {
+      this->emplace(std::move(init_));
+      return;
+    }
+    this->emplace(::portable_concurrency::cxx14_v1::detail::invoke(
+        func_, std::move(init_), std::move(acc_.get(in_place_index_t<1>{}))));
+  }
+
+  const I first_;
+  T init_;
+  std::decay_t<F> func_;
+  std::mutex mutex_;
+  either<monostate, T> acc_;
+};
+
+template <typename E, typename I, typename C>
+class sort_state final : public parallel_state<void, E> {
+public:
+  using value_type = void;
+
+  sort_state(const E &exec, std::size_t grain, I first, C &&comp)
+      : parallel_state<void, E>(exec), grain_(grain == 0 ? 1 : grain),
+        first_(first), comp_(std::forward<C>(comp)) {}
+
+  // Quicksort partitioning the chunk until it is small enough to be sorted
+  // sequentially. Right parts are posted as separate chunks.
+  void run(std::size_t begin, std::size_t end, unsigned) noexcept {
+    try {
+      while (end - begin > grain_) {
+        const I b = at(begin);
+        const I e = at(end);
+        auto pivot = median(*b, *at(begin + (end - begin) / 2), *(e - 1));
+        const I less_end = std::partition(
+            b, e, [&](const auto &val) { return comp_(val, pivot); });
+        const I equal_end = std::partition(
+            less_end, e, [&](const auto &val) { return !comp_(pivot, val); });
+        const std::size_t right = begin + static_cast<std::size_t>(
+                                              std::distance(b, equal_end));
+        if (end - right > 1)
+          this->spawn(chunk_task<sort_state>{this, right, end, 0});
+        end = begin + static_cast<std::size_t>(std::distance(b, less_end));
+      }
+      std::sort(at(begin), at(end), std::ref(comp_));
+    } catch (...) {
+      this->fail(std::current_exception());
+    }
+    this->complete();
+  }
+
+private:
+  I at(std::size_t idx) const {
+    using diff_t = typename std::iterator_traits<I>::difference_type;
+    return first_ + static_cast<diff_t>(idx);
+  }
+
+  template <typename T> T median(const T &a, const T &b, const T &c) {
+    if (comp_(a, b))
+      return comp_(b, c) ? b : (comp_(a, c) ? c : a);
+    return comp_(a, c) ? a : (comp_(b, c) ? c : b);
+  }
+
+  void set_result() override { this->emplace(); }
+
+  const std::size_t grain_;
+  const I first_;
+  std::decay_t<C> comp_;
+};
+
+} // namespace detail
+
+/**
+ * @headerfile portable_concurrency/parallel_algorithm
+ * @ingroup parallel_algorithm
+ * @brief Invokes function `func` for each element of the range `[first, last)`
+ * using executor `exec`.
+ *
+ * The range is either a pair of random access iterators or a pair of integral
+ * indexes in which case `func` is invoked with each index from the range. The
+ * range is split into chunks which are processed sequentially. Chunks are
+ * split further when they are picked up by idle threads of the executor but
+ * they are never split into parts smaller than `grain` elements.
+ *
+ * Returns future which becomes ready when all of the elements are processed.
+ * If some invocations of `func` exit via exception the future holds one of
+ * those exceptions. The range and the function must stay valid until then.
+ *
+ * The function participates in overload resolution only if
+ * `is_executor<E>::value` is `true`.
+ */
+template <typename E, typename I, typename F>
+PC_NODISCARD auto parallel_for(E &&exec, I first, I last, std::size_t grain,
+                               F &&func)
+    -> std::enable_if_t<is_executor<std::decay_t<E>>::value, future<void>> {
+  using state_t = detail::for_each_state<std::decay_t<E>, I, F>;
+  return detail::start_parallel<state_t>(detail::range_size(first, last),
+                                         exec, grain, first,
+                                         std::forward<F>(func));
+}
+
+/**
+ * @headerfile portable_concurrency/parallel_algorithm
+ * @ingroup parallel_algorithm
+ * @brief Stores results of the function `func` applied to each element of the
+ * range `[first, last)` to the range beginning at `d_first` using executor
+ * `exec`.
+ *
+ * Output range is addressed with random access iterator `d_first`. Chunking and
+ * error handling are the same as in @ref parallel_for. Returns future which
+ * holds the output iterator to the element past the last one written.
+ *
+ * The function participates in overload resolution only if
+ * `is_executor<E>::value` is `true`.
+ */
+template <typename E, typename I, typename O, typename F>
+PC_NODISCARD auto parallel_transform(E &&exec, I first, I last, O d_first,
+                                     std::size_t grain, F &&func)
+    -> std::enable_if_t<is_executor<std::decay_t<E>>::value, future<O>> {
+  using state_t = detail::transform_state<std::decay_t<E>, I, O, F>;
+  const std::size_t size = detail::range_size(first, last);
+  return detail::start_parallel<state_t>(size, exec, grain, first, size,
+                                         d_first, std::forward<F>(func));
+}
+
+/**
+ * @headerfile portable_concurrency/parallel_algorithm
+ * @ingroup parallel_algorithm
+ * @brief Reduces the range `[first, last)` with the binary operation `func`
+ * using executor `exec`.
+ *
+ * Works as `std::reduce`: elements and partial results are combined in an
+ * unspecified order so `func` must be both associative and commutative.
+ * Chunking and error handling are the same as in @ref parallel_for. Returns
+ * future which holds the reduction result or `init` for the empty range.
+ *
+ * The function participates in overload resolution only if
+ * `is_executor<E>::value` is `true`.
+ */
+template <typename E, typename I, typename T, typename F = std::plus<>>
+PC_NODISCARD auto parallel_reduce(E &&exec, I first, I last, std::size_t grain,
+                                  T init, F &&func = F{})
+    -> std::enable_if_t<is_executor<std::decay_t<E>>::value, future<T>> {
+  using state_t = detail::reduce_state<std::decay_t<E>, I, T, F>;
+  return detail::start_parallel<state_t>(detail::range_size(first, last),
+                                         exec, grain, first, std::move(init),
+                                         std::forward<F>(func));
+}
+
+/**
+ * @headerfile portable_concurrency/parallel_algorithm
+ * @ingroup parallel_algorithm
+ * @brief Sorts the range of random access iterators `[first, last)` using
+ * executor `exec`.
+ *
+ * Parallel quicksort: the range is partitioned until the parts are not larger
+ * than `grain` elements and those parts are sorted with `std::sort`. Each
+ * partitioning step posts one of the parts as a separate task. The sort is not
+ * stable. Returns future which becomes ready when the whole range is sorted.
+ *
+ * The function participates in overload resolution only if
+ * `is_executor<E>::value` is `true`.
+ */
+template <typename E, typename I, typename C = std::less<>>
+PC_NODISCARD auto parallel_sort(E &&exec, I first, I last, std::size_t grain,
+                                C &&comp = C{})
+    -> std::enable_if_t<is_executor<std::decay_t<E>>::value, future<void>> {
+  using state_t = detail::sort_state<std::decay_t<E>, I, C>;
+  return detail::start_parallel<state_t>(detail::range_size(first, last),
+                                         exec, grain, first,
+                                         std::forward<C>(comp));
+}
+
+} // namespace cxx14_v1
+} // namespace portable_concurrency
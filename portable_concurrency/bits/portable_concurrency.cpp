@@ -1,10 +1,14 @@
 #include <atomic>
+#include <cstddef>
 #include <functional>
 #include <future>
+#include <vector>
 
-#include "closable_queue.hpp"
+#include "blocking_observer.h"
+#include "cpu_relax.h"
 #include "future.hpp"
 #include "future_state.h"
+#include "futex.h"
 #include "latch.h"
 #include "make_future.h"
 #include "once_consumable_stack.hpp"
@@ -12,7 +16,6 @@
 #include "shared_future.hpp"
 #include "shared_state.h"
 #include "small_unique_function.hpp"
-#include "thread_pool.h"
 #include "unique_function.hpp"
 #include "when_all.h"
 #include "when_any.h"
@@ -32,29 +35,132 @@ void continuations_stack::push(continuation &&cnt) {
     cnt();
 }
 
-void continuations_stack::execute() {
-  auto continuations = stack_.consume();
+namespace {
+
+std::atomic<unsigned> max_inline_depth{32};
+
+// Continuations postponed by the nested `execute` calls which exceeded the
+// maximum inline depth. They are executed in FIFO order by the outermost one.
+struct trampoline {
+  unsigned depth = 0;
+  std::size_t next = 0;
+  std::vector<consumed_items<continuation>> postponed;
+};
+
+trampoline &current_trampoline() noexcept {
+  static thread_local trampoline instance;
+  return instance;
+}
+
+class depth_guard {
+public:
+  explicit depth_guard(trampoline &t) noexcept : t_{t} { ++t_.depth; }
+  ~depth_guard() { --t_.depth; }
+
+  depth_guard(const depth_guard &) = delete;
+  depth_guard &operator=(const depth_guard &) = delete;
+
+private:
+  trampoline &t_;
+};
+
+void run(consumed_items<continuation> &continuations) {
   for (auto &cnt : continuations)
     cnt();
 }
 
+void run_postponed(trampoline &t) {
+  depth_guard guard{t};
+  while (t.next < t.postponed.size()) {
+    // Moved out since running continuations may postpone more of them
+    auto continuations = std::move(t.postponed[t.next++]);
+    run(continuations);
+  }
+  t.postponed.clear();
+  t.next = 0;
+}
+
+} // namespace
+
+void continuations_stack::execute() {
+  auto continuations = stack_.consume();
+  if (readiness_.exchange(ready, std::memory_order_acq_rel) == has_waiters)
+    futex_wake_all(readiness_);
+  if (continuations.begin() == continuations.end())
+    return;
+
+  auto &t = current_trampoline();
+  if (t.depth != 0 &&
+      t.depth >= max_inline_depth.load(std::memory_order_relaxed)) {
+    t.postponed.push_back(std::move(continuations));
+    return;
+  }
+  {
+    depth_guard guard{t};
+    run(continuations);
+  }
+  if (t.depth == 0 && t.next < t.postponed.size())
+    run_postponed(t);
+}
+
 bool continuations_stack::executed() const { return stack_.is_consumed(); }
 
-void wait(future_state_base &state) {
-  std::mutex mtx;
-  std::condition_variable cv;
-  bool ready = false;
-  state.push([&] {
-    std::lock_guard<std::mutex> guard{mtx};
-    ready = true;
-    cv.notify_one();
-  });
+bool continuations_stack::empty() const { return stack_.empty(); }
+
+void continuations_stack::discard() noexcept { stack_.consume(); }
 
-  std::unique_lock<std::mutex> lk{mtx};
-  cv.wait(lk, [&] { return ready; });
+void continuations_stack::wait() {
+  auto &t = current_trampoline();
+  if (t.next < t.postponed.size())
+    run_postponed(t);
+
+  constexpr unsigned spin_count = 64;
+  for (unsigned i = 0; i < spin_count; ++i) {
+    if (readiness_.load(std::memory_order_acquire) == ready)
+      return;
+    cpu_relax();
+  }
+
+  auto val = readiness_.load(std::memory_order_acquire);
+  if (val == ready)
+    return;
+  blocking_region blocking;
+  while (val != ready) {
+    if (val == not_ready &&
+        !readiness_.compare_exchange_weak(val, has_waiters,
+                                          std::memory_order_acquire))
+      continue;
+    futex_wait(readiness_, has_waiters);
+    val = readiness_.load(std::memory_order_acquire);
+  }
+}
+
+blocking_observer *&current_blocking_observer() noexcept {
+  static thread_local blocking_observer *observer = nullptr;
+  return observer;
 }
 
-template class closable_queue<unique_function<void()>>;
+bool continuations_stack::wait_for(std::chrono::nanoseconds timeout) {
+  auto &t = current_trampoline();
+  if (t.next < t.postponed.size())
+    run_postponed(t);
+
+  auto val = readiness_.load(std::memory_order_acquire);
+  if (val == ready)
+    return true;
+  if (timeout <= std::chrono::nanoseconds::zero())
+    return false;
+  if (val == not_ready &&
+      !readiness_.compare_exchange_strong(val, has_waiters,
+                                          std::memory_order_acquire) &&
+      val == ready)
+    return true;
+  blocking_region blocking;
+  futex_wait_for(readiness_, has_waiters, timeout);
+  return readiness_.load(std::memory_order_acquire) == ready;
+}
+
+void wait(future_state_base &state) { state.continuations().wait(); }
 
 [[noreturn]] void throw_no_state() {
   throw std::future_error{std::future_errc::no_state};
@@ -79,71 +185,76 @@ void future_state_base::push(continuation &&cnt) {
 
 } // namespace detail
 
-namespace {
-
-// P0443R7 states that if task submitted to static_thread_pool exits via
-// exception then std::terminate is called. This behavior is established by
-// marking this function noexcept.
-void process_queue(
-  detail::closable_queue<unique_function<void()>> &queue,
-  const std::atomic<bool> &stopped
-) noexcept {
-  unique_function<void()> task;
-  while (!stopped.load(std::memory_order_relaxed) && queue.pop(task))
-    task();
+void set_inline_continuations_depth(unsigned depth) noexcept {
+  detail::max_inline_depth.store(depth, std::memory_order_relaxed);
 }
 
-} // namespace
+unsigned inline_continuations_depth() noexcept {
+  return detail::max_inline_depth.load(std::memory_order_relaxed);
+}
 
-template class unique_function<void()>;
+template class basic_unique_function<void()>;
 
 latch::~latch() {
-  std::unique_lock<std::mutex> lock{mutex_};
-  cv_.wait(lock, [this] { return waiters_ == 0; });
+  // Threads woken up by the latch might still access it
+  for (auto n = waiters_.load(std::memory_order_acquire); n != 0;
+       n = waiters_.load(std::memory_order_acquire))
+    detail::futex_wait(waiters_, n);
 }
 
 void latch::count_down_and_wait() {
-  std::unique_lock<std::mutex> lock{mutex_};
-  ++waiters_;
-  assert(counter_ > 0);
-  if (--counter_ == 0) {
-    --waiters_;
-    cv_.notify_all();
-    return;
-  }
-  cv_.wait(lock, [this] { return counter_ == 0; });
-  if (--waiters_ == 0)
-    cv_.notify_one();
+  // Registered before the count down so that the latch is not destroyed by
+  // the thread woken up by this count down while this one is still using it
+  waiters_.fetch_add(1, std::memory_order_relaxed);
+  count_down();
+  block();
 }
 
 void latch::count_down(ptrdiff_t n) {
-  {
-    std::lock_guard<std::mutex> lock{mutex_};
-    assert(counter_ >= n);
-    assert(n >= 0);
-    counter_ -= n;
-    if (counter_ > 0)
-      return;
-  }
-  cv_.notify_all();
+  assert(n >= 0);
+  const ptrdiff_t prev = counter_.fetch_sub(n, std::memory_order_acq_rel);
+  assert(prev >= n);
+  if (prev != n)
+    return;
+  if (readiness_.exchange(ready, std::memory_order_acq_rel) == has_waiters)
+    detail::futex_wake_all(readiness_);
 }
 
 bool latch::is_ready() const noexcept {
-  std::lock_guard<std::mutex> lock{mutex_};
-  return counter_ == 0;
+  return readiness_.load(std::memory_order_acquire) == ready;
 }
 
 void latch::wait() const {
-  std::unique_lock<std::mutex> lock{mutex_};
-  ++waiters_;
-  cv_.wait(lock, [this] { return counter_ == 0; });
-  if (--waiters_ == 0)
-    cv_.notify_one();
+  if (readiness_.load(std::memory_order_acquire) == ready)
+    return;
+  waiters_.fetch_add(1, std::memory_order_relaxed);
+  block();
+}
+
+void latch::block() const {
+  auto val = readiness_.load(std::memory_order_acquire);
+  if (val == not_ready &&
+      readiness_.compare_exchange_strong(val, has_waiters,
+                                         std::memory_order_acquire))
+    val = has_waiters;
+  detail::blocking_region blocking;
+  while (val != ready) {
+    detail::futex_wait(readiness_, has_waiters);
+    val = readiness_.load(std::memory_order_acquire);
+  }
+  if (waiters_.fetch_sub(1, std::memory_order_release) == 1)
+    detail::futex_wake_all(waiters_);
 }
 
 template <> void future<void>::get() {
-  if (!state_)
-    throw std::future_error(std::future_errc::no_state);
+  if (!state_) {
+    if (!has_ready_value())
+      throw std::future_error(std::future_errc::no_state);
+    auto value = take_ready_value();
+    if (value.state() == 2)
+      std::rethrow_exception(value.get(detail::in_place_index_t<2>{}));
+    return;
+  }
   wait();
   auto state = std::move(state_);
   state->value_ref();
@@ -158,9 +269,7 @@ typename shared_future<void>::get_result_type shared_future<void>::get() const {
 }
 
 future<void> make_ready_future() {
-  auto promise_and_future = make_promise<void>();
-  promise_and_future.first.set_value();
-  return std::move(promise_and_future.second);
+  return detail::ready_value_t<void>{detail::in_place_index_t<1>{}};
 }
 
 future<std::tuple<>> when_all() { return make_ready_future(std::tuple<>{}); }
@@ -170,44 +279,5 @@ future<when_any_result<std::tuple<>>> when_any() {
       static_cast<std::size_t>(-1), std::tuple<>{}});
 }
 
-static_thread_pool::static_thread_pool(std::size_t num_threads) {
-  threads_.reserve(num_threads);
-  while (num_threads-- > 0)
-    threads_.push_back(std::thread{&static_thread_pool::attach, this});
-}
-
-static_thread_pool::~static_thread_pool() {
-  stop();
-  wait();
-}
-
-void static_thread_pool::attach() {
-  {
-    std::lock_guard<std::mutex> lock{mutex_};
-    ++attached_threads_;
-  }
-  process_queue(queue_, stopped_);
-  {
-    std::unique_lock<std::mutex> lock{mutex_};
-    --attached_threads_;
-    cv_.wait(lock, [&] { return attached_threads_ == 0; });
-  }
-  cv_.notify_all();
-}
-
-void static_thread_pool::stop() { 
-  stopped_.store(true, std::memory_order_relaxed);
-  queue_.close();
-}
-
-void static_thread_pool::wait() {
-  queue_.close();
-  for (auto &thread : threads_) {
-    if (thread.joinable())
-      thread.join();
-  }
-  threads_.clear();
-}
-
 } // namespace cxx14_v1
 } // namespace portable_concurrency
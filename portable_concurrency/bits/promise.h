@@ -21,39 +21,42 @@ public:
   cancellable_state(cancellable_state &&) = delete;
   cancellable_state &operator=(cancellable_state &&) = delete;
 
-  ~cancellable_state() noexcept {
-    if (!this->continuations().executed())
-      cancel_action();
-  }
-
   cancellable_state(const F &action)
-      : shared_state<T>{}, cancel_action{action} {}
+      : shared_state<T>{}, cancel_action{in_place_index_t<1>{}, action} {}
   cancellable_state(F &&action)
-      : shared_state<T>{}, cancel_action{std::move(action)} {}
+      : shared_state<T>{}, cancel_action{in_place_index_t<1>{},
+                                         std::move(action)} {}
+
+private:
+  void dispose() noexcept override {
+    if (!this->continuations().executed())
+      cancel_action.get(in_place_index_t<1>{})();
+    cancel_action.clean();
+    shared_state<T>::dispose();
+  }
 
 private:
-  F cancel_action;
+  either<monostate, F> cancel_action;
 };
 
 template <typename T> struct promise_common {
-  either<detail::monostate, std::shared_ptr<shared_state<T>>,
-         std::weak_ptr<shared_state<T>>>
+  either<detail::monostate, state_ptr<shared_state<T>>,
+         weak_state_ptr<shared_state<T>>>
       state_;
 
   promise_common()
-      : state_{in_place_index_t<1>{}, std::make_shared<shared_state<T>>()} {}
+      : state_{in_place_index_t<1>{}, make_state<shared_state<T>>()} {}
   template <typename Alloc>
   explicit promise_common(const Alloc &allocator)
       : state_{in_place_index_t<1>{},
-               std::allocate_shared<allocated_state<T, Alloc>>(allocator,
-                                                               allocator)} {}
+               allocate_state<shared_state<T>>(allocator)} {}
   template <typename F>
   promise_common(canceler_arg_t, F &&f)
       : state_{in_place_index_t<1>{},
-               std::make_shared<cancellable_state<T, std::decay_t<F>>>(
+               make_state<cancellable_state<T, std::decay_t<F>>>(
                    std::forward<F>(f))} {}
 
-  promise_common(std::weak_ptr<detail::shared_state<T>> &&state)
+  promise_common(weak_state_ptr<detail::shared_state<T>> &&state)
       : state_{in_place_index_t<2>{}, std::move(state)} {}
 
   ~promise_common() { abandon(); }
@@ -67,11 +70,11 @@ template <typename T> struct promise_common {
 
   void abandon() {
     struct {
-      void operator()(const std::weak_ptr<shared_state<T>> &wstate) {
+      void operator()(const weak_state_ptr<shared_state<T>> &wstate) {
         if (auto state = wstate.lock())
           state->abandon();
       }
-      void operator()(const std::shared_ptr<shared_state<T>> &) {}
+      void operator()(const state_ptr<shared_state<T>> &) {}
       void operator()(monostate) {}
     } visitor;
     state_.visit(visitor);
@@ -82,7 +85,7 @@ template <typename T> struct promise_common {
       throw_already_retrieved();
     auto state = get_state();
     state_.emplace(in_place_index_t<2>{}, state);
-    return {state};
+    return {std::move(state)};
   }
 
   void set_exception(std::exception_ptr error) {
@@ -91,17 +94,17 @@ template <typename T> struct promise_common {
       state->set_exception(error);
   }
 
-  std::shared_ptr<shared_state<T>> get_state() {
+  state_ptr<shared_state<T>> get_state() {
     struct {
-      std::shared_ptr<shared_state<T>>
-      operator()(const std::shared_ptr<shared_state<T>> &val) const {
+      state_ptr<shared_state<T>>
+      operator()(const state_ptr<shared_state<T>> &val) const {
         return val;
       }
-      std::shared_ptr<shared_state<T>>
-      operator()(const std::weak_ptr<shared_state<T>> &val) const {
+      state_ptr<shared_state<T>>
+      operator()(const weak_state_ptr<shared_state<T>> &val) const {
         return val.lock();
       }
-      std::shared_ptr<shared_state<T>> operator()(monostate) {
+      state_ptr<shared_state<T>> operator()(monostate) {
         throw_no_state();
       }
     } visitor;
@@ -110,10 +113,10 @@ template <typename T> struct promise_common {
 
   bool is_awaiten() const {
     struct {
-      bool operator()(const std::shared_ptr<shared_state<T>> &) const {
+      bool operator()(const state_ptr<shared_state<T>> &) const {
         return true;
       }
-      bool operator()(const std::weak_ptr<shared_state<T>> &val) const {
+      bool operator()(const weak_state_ptr<shared_state<T>> &val) const {
         return !val.expired();
       }
       bool operator()(monostate) const { throw_no_state(); }
@@ -137,7 +140,7 @@ public:
   template <typename F>
   promise(canceler_arg_t tag, F &&f) : common_{tag, std::forward<F>(f)} {}
 
-  promise(std::weak_ptr<detail::shared_state<T>> &&state)
+  promise(detail::weak_state_ptr<detail::shared_state<T>> &&state)
       : common_(std::move(state)) {}
 
   promise(promise &&) noexcept = default;
@@ -198,7 +201,7 @@ public:
   template <typename F>
   promise(canceler_arg_t tag, F &&f) : common_{tag, std::forward<F>(f)} {}
 
-  promise(std::weak_ptr<detail::shared_state<T &>> &&state)
+  promise(detail::weak_state_ptr<detail::shared_state<T &>> &&state)
       : common_(std::move(state)) {}
 
   promise(promise &&) noexcept = default;
@@ -245,7 +248,7 @@ public:
   template <typename F>
   promise(canceler_arg_t tag, F &&f) : common_{tag, std::forward<F>(f)} {}
 
-  promise(std::weak_ptr<detail::shared_state<void>> &&state)
+  promise(detail::weak_state_ptr<detail::shared_state<void>> &&state)
       : common_(std::move(state)) {}
 
   promise(promise &&) noexcept = default;
@@ -285,26 +288,26 @@ private:
 
 template <typename T>
 PC_NODISCARD std::pair<promise<T>, future<T>> make_promise() {
-  auto state = std::make_shared<detail::shared_state<T>>();
-  auto state_weak = std::weak_ptr<detail::shared_state<T>>(state);
+  auto state = detail::make_state<detail::shared_state<T>>();
+  auto state_weak = detail::weak_state_ptr<detail::shared_state<T>>(state);
   return {promise<T>(std::move(state_weak)), future<T>(std::move(state))};
 }
 
 template <typename T, typename Alloc>
 PC_NODISCARD std::pair<promise<T>, future<T>>
 make_promise(const Alloc &allocator) {
-  auto state = std::allocate_shared<detail::allocated_state<T, Alloc>>(
-      allocator, allocator);
-  auto state_weak = std::weak_ptr<detail::shared_state<T>>(state);
+  auto state = detail::allocate_state<detail::shared_state<T>>(allocator);
+  auto state_weak = detail::weak_state_ptr<detail::shared_state<T>>(state);
   return {promise<T>(std::move(state_weak)), future<T>(std::move(state))};
 }
 
 template <typename T, typename F>
 PC_NODISCARD std::pair<promise<T>, future<T>> make_promise(canceler_arg_t,
                                                            F &&f) {
-  auto state = std::make_shared<detail::cancellable_state<T, std::decay_t<F>>>(
-      std::forward<F>(f));
-  auto state_weak = std::weak_ptr<detail::shared_state<T>>(state);
+  auto state =
+      detail::make_state<detail::cancellable_state<T, std::decay_t<F>>>(
+          std::forward<F>(f));
+  auto state_weak = detail::weak_state_ptr<detail::shared_state<T>>(state);
   return {promise<T>(std::move(state_weak)), future<T>(std::move(state))};
 }
 
@@ -8,6 +8,8 @@
 
 #include "concurrency_type_traits.h"
 #include "coro.h"
+#include "future.h"
+#include "state_ptr.h"
 
 #include <portable_concurrency/bits/config.h>
 
@@ -33,7 +35,7 @@ public:
   shared_future() noexcept = default;
   shared_future(const shared_future &) noexcept = default;
   shared_future(shared_future &&) noexcept = default;
-  shared_future(future<T> &&rhs) noexcept;
+  shared_future(future<T> &&rhs) noexcept(!detail::stored_inline<T>::value);
 
   shared_future &operator=(const shared_future &) noexcept = default;
   shared_future &operator=(shared_future &&) noexcept = default;
@@ -106,6 +108,30 @@ public:
   PC_NODISCARD detail::add_future_t<detail::promise_arg_t<F, shared_future<T>>>
   then(E &&exec, F &&f);
 
+  template <typename Alloc, typename F>
+  PC_NODISCARD detail::cnt_future_t<F, shared_future<T>>
+  then(std::allocator_arg_t, const Alloc &allocator, F &&f) const;
+
+  template <typename Alloc, typename E, typename F>
+  PC_NODISCARD detail::cnt_future_t<F, shared_future<T>>
+  then(std::allocator_arg_t, const Alloc &allocator, E &&exec, F &&f) const;
+
+  template <typename Alloc, typename F>
+  PC_NODISCARD detail::cnt_future_t<F, get_result_type>
+  next(std::allocator_arg_t, const Alloc &allocator, F &&f) const;
+
+  template <typename Alloc, typename E, typename F>
+  PC_NODISCARD detail::cnt_future_t<F, get_result_type>
+  next(std::allocator_arg_t, const Alloc &allocator, E &&exec, F &&f) const;
+
+  template <typename Alloc, typename F>
+  PC_NODISCARD detail::add_future_t<detail::promise_arg_t<F, shared_future<T>>>
+  then(std::allocator_arg_t, const Alloc &allocator, F &&f);
+
+  template <typename Alloc, typename E, typename F>
+  PC_NODISCARD detail::add_future_t<detail::promise_arg_t<F, shared_future<T>>>
+  then(std::allocator_arg_t, const Alloc &allocator, E &&exec, F &&f);
+
   /**
    * Prevents cancellation of the operations of this shared_future value
    * calculation on its destruction.
@@ -115,7 +141,7 @@ public:
   shared_future detach();
 
   // Implementation detail
-  shared_future(std::shared_ptr<detail::future_state<T>> &&state) noexcept;
+  shared_future(detail::state_ptr<detail::future_state<T>> &&state) noexcept;
 
 #if defined(PC_HAS_COROUTINES)
   // Coroutines TS support
@@ -126,13 +152,13 @@ public:
 #endif
 
 private:
-  friend std::shared_ptr<detail::future_state<T>> &
+  friend detail::state_ptr<detail::future_state<T>> &
   detail::state_of<T>(shared_future<T> &);
-  friend std::shared_ptr<detail::future_state<T>>
+  friend detail::state_ptr<detail::future_state<T>>
   detail::state_of<T>(shared_future<T> &&);
 
 private:
-  std::shared_ptr<detail::future_state<T>> state_;
+  detail::state_ptr<detail::future_state<T>> state_;
 };
 
 template <>
@@ -14,8 +14,9 @@ namespace portable_concurrency {
 inline namespace cxx14_v1 {
 
 template <typename T>
-shared_future<T>::shared_future(future<T> &&rhs) noexcept
-    : state_(std::move(rhs.state_)) {}
+shared_future<T>::shared_future(future<T> &&rhs) noexcept(
+    !detail::stored_inline<T>::value)
+    : state_(std::move(rhs.materialize())) {}
 
 template <typename T> void shared_future<T>::wait() const {
   if (!state_)
@@ -111,58 +112,116 @@ template <typename T>
 template <typename E, typename F>
 PC_NODISCARD detail::cnt_future_t<F, shared_future<T>>
 shared_future<T>::then(E &&exec, F &&f) const {
+  return then(std::allocator_arg, std::allocator<void>{},
+              std::forward<E>(exec), std::forward<F>(f));
+}
+
+template <typename T>
+template <typename F>
+PC_NODISCARD detail::cnt_future_t<F, typename shared_future<T>::get_result_type>
+shared_future<T>::next(F &&f) const {
+  return next(inplace_executor, std::forward<F>(f));
+}
+
+template <typename T>
+template <typename E, typename F>
+PC_NODISCARD detail::cnt_future_t<F, typename shared_future<T>::get_result_type>
+shared_future<T>::next(E &&exec, F &&f) const {
+  return next(std::allocator_arg, std::allocator<void>{},
+              std::forward<E>(exec), std::forward<F>(f));
+}
+
+template <typename T>
+template <typename F>
+PC_NODISCARD detail::add_future_t<detail::promise_arg_t<F, shared_future<T>>>
+shared_future<T>::then(F &&f) {
+  return then(inplace_executor, std::forward<F>(f));
+}
+
+template <typename T>
+template <typename E, typename F>
+PC_NODISCARD detail::add_future_t<detail::promise_arg_t<F, shared_future<T>>>
+shared_future<T>::then(E &&exec, F &&f) {
+  return then(std::allocator_arg, std::allocator<void>{},
+              std::forward<E>(exec), std::forward<F>(f));
+}
+
+template <typename T>
+template <typename Alloc, typename F>
+PC_NODISCARD detail::cnt_future_t<F, shared_future<T>>
+shared_future<T>::then(std::allocator_arg_t, const Alloc &allocator,
+                       F &&f) const {
+  return then(std::allocator_arg, allocator, inplace_executor,
+              std::forward<F>(f));
+}
+
+/**
+ * Attaches continuation function `f` to this shared_future object. Shared
+ * state of the returned future and the node of this shared_future
+ * continuations stack are allocated with the `allocator`. [EXTENSION]
+ */
+template <typename T>
+template <typename Alloc, typename E, typename F>
+PC_NODISCARD detail::cnt_future_t<F, shared_future<T>>
+shared_future<T>::then(std::allocator_arg_t, const Alloc &allocator, E &&exec,
+                       F &&f) const {
   static_assert(is_executor<std::decay_t<E>>::value, "E must be an executor");
   using result_type =
       detail::remove_future_t<detail::cnt_result_t<F, shared_future<T>>>;
   if (!state_)
     detail::throw_no_state();
   return detail::make_then_state<result_type>(
-      state_->continuations(), std::forward<E>(exec),
+      *state_, allocator, std::forward<E>(exec),
       detail::decorate_shared_then<result_type, T, F>(std::forward<F>(f),
                                                       state_));
 }
 
 template <typename T>
-template <typename F>
+template <typename Alloc, typename F>
 PC_NODISCARD detail::cnt_future_t<F, typename shared_future<T>::get_result_type>
-shared_future<T>::next(F &&f) const {
-  return next(inplace_executor, std::forward<F>(f));
+shared_future<T>::next(std::allocator_arg_t, const Alloc &allocator,
+                       F &&f) const {
+  return next(std::allocator_arg, allocator, inplace_executor,
+              std::forward<F>(f));
 }
 
 template <typename T>
-template <typename E, typename F>
+template <typename Alloc, typename E, typename F>
 PC_NODISCARD detail::cnt_future_t<F, typename shared_future<T>::get_result_type>
-shared_future<T>::next(E &&exec, F &&f) const {
+shared_future<T>::next(std::allocator_arg_t, const Alloc &allocator, E &&exec,
+                       F &&f) const {
   static_assert(is_executor<std::decay_t<E>>::value, "E must be an executor");
   using result_type = detail::remove_future_t<
       detail::cnt_result_t<F, typename shared_future<T>::get_result_type>>;
   if (!state_)
     detail::throw_no_state();
   return detail::make_then_state<result_type>(
-      state_->continuations(), std::forward<E>(exec),
+      *state_, allocator, std::forward<E>(exec),
       detail::decorate_shared_next<result_type, T, F>(std::forward<F>(f),
                                                       state_));
 }
 
 template <>
-template <typename E, typename F>
+template <typename Alloc, typename E, typename F>
 PC_NODISCARD
     detail::cnt_future_t<F, typename shared_future<void>::get_result_type>
-    shared_future<void>::next(E &&exec, F &&f) const {
+    shared_future<void>::next(std::allocator_arg_t, const Alloc &allocator,
+                              E &&exec, F &&f) const {
   static_assert(is_executor<std::decay_t<E>>::value, "E must be an executor");
   using result_type = detail::remove_future_t<detail::cnt_result_t<F, void>>;
   if (!state_)
     detail::throw_no_state();
   return detail::make_then_state<result_type>(
-      state_->continuations(), std::forward<E>(exec),
+      *state_, allocator, std::forward<E>(exec),
       detail::decorate_void_next<result_type, F>(std::forward<F>(f), state_));
 }
 
 template <typename T>
-template <typename F>
+template <typename Alloc, typename F>
 PC_NODISCARD detail::add_future_t<detail::promise_arg_t<F, shared_future<T>>>
-shared_future<T>::then(F &&f) {
-  return then(inplace_executor, std::forward<F>(f));
+shared_future<T>::then(std::allocator_arg_t, const Alloc &allocator, F &&f) {
+  return then(std::allocator_arg, allocator, inplace_executor,
+              std::forward<F>(f));
 }
 
 /**
@@ -178,23 +237,27 @@ shared_future<T>::then(F &&f) {
  *  * to move it into another promise which will be used to set value or
  * exception by some other operation
  *
+ * Shared state of the returned future and the node of this shared_future
+ * continuations stack are allocated with the `allocator`.
+ *
  * If continuation function exits via exception std::terminate is called
  */
 template <typename T>
-template <typename E, typename F>
+template <typename Alloc, typename E, typename F>
 PC_NODISCARD detail::add_future_t<detail::promise_arg_t<F, shared_future<T>>>
-shared_future<T>::then(E &&exec, F &&f) {
+shared_future<T>::then(std::allocator_arg_t, const Alloc &allocator, E &&exec,
+                       F &&f) {
   static_assert(is_executor<std::decay_t<E>>::value, "E must be an executor");
   using result_type = detail::promise_arg_t<F, shared_future<T>>;
   if (!state_)
     detail::throw_no_state();
-  detail::continuations_stack &subscriptions = state_->continuations();
+  detail::future_state_base &state_ref = *state_;
   return detail::make_then_state<result_type>(
-      subscriptions, std::forward<E>(exec),
+      state_ref, allocator, std::forward<E>(exec),
       [f = std::forward<F>(f), parent = std::move(state_)](
-          std::shared_ptr<detail::shared_state<result_type>>
+          detail::state_ptr<detail::shared_state<result_type>>
               state) mutable noexcept {
-        promise<result_type> p{std::exchange(state, nullptr)};
+        promise<result_type> p{std::move(state)};
         ::portable_concurrency::detail::invoke(
             f, std::move(p), shared_future<T>{std::move(parent)});
       });
@@ -210,7 +273,7 @@ template <typename T> shared_future<T> shared_future<T>::detach() {
 
 template <typename T>
 shared_future<T>::shared_future(
-    std::shared_ptr<detail::future_state<T>> &&state) noexcept
+    detail::state_ptr<detail::future_state<T>> &&state) noexcept
     : state_(std::move(state)) {}
 
 #if defined(PC_HAS_COROUTINES)
@@ -233,13 +296,13 @@ void shared_future<T>::await_suspend(detail::coroutine_handle<> handle) const {
 namespace detail {
 
 template <typename T>
-std::shared_ptr<future_state<T>> &state_of(shared_future<T> &f) {
+state_ptr<future_state<T>> &state_of(shared_future<T> &f) {
   return f.state_;
 }
 
 template <typename T>
-std::shared_ptr<future_state<T>> state_of(shared_future<T> &&f) {
-  return f.state_;
+state_ptr<future_state<T>> state_of(shared_future<T> &&f) {
+  return std::move(f.state_);
 }
 
 } // namespace detail
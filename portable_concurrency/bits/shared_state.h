@@ -1,7 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <exception>
+#include <memory>
 #include <stdexcept>
 #include <type_traits>
 
@@ -30,6 +32,7 @@ public:
       throw_already_satisfied();
     storage_.emplace(in_place_index_t<1>{}, std::forward<U>(u)...);
     this->continuations().execute();
+    notify_forwarder();
   }
 
   void set_exception(std::exception_ptr error) {
@@ -37,10 +40,11 @@ public:
       throw_already_satisfied();
     storage_.emplace(in_place_index_t<3>{}, error);
     this->continuations().execute();
+    notify_forwarder();
   }
 
   void abandon() {
-    // In case of unwrap state == 2 (storage holds shared_ptr<shared_state<T>>)
+    // In case of unwrap state == 2 (storage holds state_ptr<future_state<T>>)
     // and continuations will be executed when storesd state is fulfilled.
     if (!continuations().executed() && storage_.state() != 2)
       set_exception(make_broken_promise());
@@ -53,7 +57,7 @@ public:
         return val;
       }
       state_storage_t<T> &
-      operator()(std::shared_ptr<future_state<T>> &val) const {
+      operator()(state_ptr<future_state<T>> &val) const {
         return val->value_ref();
       }
       state_storage_t<T> &operator()(std::exception_ptr &err) const {
@@ -75,7 +79,7 @@ public:
         return nullptr;
       }
       std::exception_ptr
-      operator()(std::shared_ptr<future_state<T>> &val) const {
+      operator()(state_ptr<future_state<T>> &val) const {
         return val->exception();
       }
       std::exception_ptr operator()(std::exception_ptr &err) const {
@@ -92,57 +96,194 @@ public:
 
   continuations_stack &continuations() final { return continuations_; }
 
-  static void unwrap(std::shared_ptr<shared_state> &self,
-                     const std::shared_ptr<future_state<T>> &val) {
+  shared_state *as_shared_state() noexcept final { return this; }
+
+  static void unwrap(state_ptr<shared_state> &self,
+                     state_ptr<future_state<T>> &&val) {
+    forward(self, std::move(val), false);
+  }
+
+  static void unwrap(state_ptr<shared_state> &self, future<T> &&val) {
+    // Ready value is taken directly from the future without allocating the
+    // shared state for it
+    auto value = take_ready_value(val);
+    switch (value.state()) {
+    case 1:
+      self->emplace(std::move(value.get(in_place_index_t<1>{})));
+      return;
+    case 2:
+      self->set_exception(value.get(in_place_index_t<2>{}));
+      return;
+    }
+    forward(self, state_of(std::move(val)), true);
+  }
+
+  static void unwrap(state_ptr<shared_state> &self, shared_future<T> &&val) {
+    unwrap(self, state_of(std::move(val)));
+  }
+
+  template <typename U>
+  static std::enable_if_t<
+      !std::is_same<std::decay_t<U>, state_ptr<future_state<T>>>::value>
+  unwrap(state_ptr<shared_state> &self, U &&val) {
+    self->emplace(std::forward<U>(val));
+  }
+
+protected:
+  void dispose() noexcept override {
+    take_forwarder();
+    storage_.clean();
+    continuations_.discard();
+  }
+
+private:
+  // Makes `self` forward the result of the `val` state. If `self` is unwrapped
+  // by another state itself and nothing else waits for it, the outer state is
+  // relinked to `val` directly and `self` is released. This way chains of
+  // asynchronously recursive continuations don't accumulate forwarding states:
+  // each of them holds the final producer of the value.
+  //
+  // `unique` means that `val` is taken from the `future` and nobody except
+  // `self` observes it.
+  static void forward(state_ptr<shared_state> &self,
+                      state_ptr<future_state<T>> &&val, bool unique) {
     assert(self);
     if (!val) {
       self->set_exception(make_broken_promise());
       return;
     }
-    self->storage_.emplace(in_place_index_t<2>{}, val);
-    val->continuations().push([wself = std::weak_ptr<shared_state>(self)] {
-      if (auto self = wself.lock())
-        self->continuations().execute();
-    });
+    auto &inner = *val;
+    auto wouter = self->take_forwarder();
+    // Continuations of `self` wait for it to become ready. Outer state is
+    // notified after them as if it pushed continuation to `self`.
+    if (wouter.get() && !self->continuations_.empty())
+      self->continuations_.push(notifier(std::move(wouter)));
+    if (auto outer = wouter.lock()) {
+      assert(outer->storage_.state() == 2);
+      self->storage_.emplace(in_place_index_t<2>{}, val);
+      outer->storage_.get(in_place_index_t<2>{}) = std::move(val);
+      link(outer, inner, unique);
+      return;
+    }
+    self->storage_.emplace(in_place_index_t<2>{}, std::move(val));
+    link(self, inner, unique);
   }
 
-  static void unwrap(std::shared_ptr<shared_state> &self, future<T> &&val) {
-    unwrap(self, state_of(std::move(val)));
+  // Makes `inner` execute continuations of the `outer` state when ready
+  static void link(const state_ptr<shared_state> &outer,
+                   future_state<T> &inner, bool unique) {
+    shared_state *inner_state = unique ? inner.as_shared_state() : nullptr;
+    if (!inner_state || !inner_state->register_forwarder(*outer))
+      inner.continuations().push(notifier(outer));
   }
 
-  static void unwrap(std::shared_ptr<shared_state> &self,
-                     shared_future<T> &&val) {
-    unwrap(self, state_of(std::move(val)));
+  static auto notifier(weak_state_ptr<shared_state> state) {
+    return [state = std::move(state)] {
+      if (auto locked = state.lock())
+        locked->continuations().execute();
+    };
   }
 
-  template <typename U>
-  static std::enable_if_t<
-      !std::is_same<std::decay_t<U>, std::shared_ptr<future_state<T>>>::value>
-  unwrap(std::shared_ptr<shared_state> &self, U &&val) {
-    self->emplace(std::forward<U>(val));
+  bool register_forwarder(shared_state &outer) noexcept {
+    outer.add_weak_ref();
+    shared_state *expected = nullptr;
+    if (forwarder_.compare_exchange_strong(expected, &outer,
+                                           std::memory_order_acq_rel))
+      return true;
+    outer.release_weak();
+    return false;
+  }
+
+  // Returns the state registered with `register_forwarder` and prevents any
+  // further registrations. Address of this state is used as marker of that.
+  weak_state_ptr<shared_state> take_forwarder() noexcept {
+    auto *outer = forwarder_.exchange(this, std::memory_order_acq_rel);
+    return {outer == this ? nullptr : outer, adopt_ref};
+  }
+
+  void notify_forwarder() {
+    if (auto outer = take_forwarder().lock())
+      outer->continuations().execute();
   }
 
 private:
-  either<monostate, state_storage_t<T>, std::shared_ptr<future_state<T>>,
+  either<monostate, state_storage_t<T>, state_ptr<future_state<T>>,
          std::exception_ptr>
       storage_;
   continuations_stack continuations_;
+  // Weak reference to the state which unwraps this one and should be notified
+  // when the value is set.
+  std::atomic<shared_state *> forwarder_{nullptr};
 };
 
-template <typename T, typename Alloc>
-class allocated_state final : private Alloc, public shared_state<T> {
+/**
+ * @internal
+ *
+ * Shared state `S` allocated with the user supplied allocator. The same
+ * allocator is used for the nodes of the continuations stack of this state.
+ */
+template <typename S, typename Alloc>
+class allocated_state final : private Alloc, public S {
 public:
-  allocated_state(const Alloc &allocator) : Alloc(allocator) {}
+  template <typename... A>
+  allocated_state(const Alloc &allocator, A &&...a)
+      : Alloc(allocator), S(std::forward<A>(a)...) {}
+
+  template <typename... A>
+  static state_ptr<allocated_state> make(const Alloc &allocator, A &&...a) {
+    state_allocator alloc{allocator};
+    auto result = state_traits::allocate(alloc, 1);
+    try {
+      state_traits::construct(alloc, result, allocator, std::forward<A>(a)...);
+    } catch (...) {
+      state_traits::deallocate(alloc, result, 1);
+      throw;
+    }
+    return {result, adopt_ref};
+  }
 
   void push(continuation &&cnt) final {
-    static_cast<shared_state<T> *>(this)->continuations().push(std::move(cnt),
-                                                               get_allocator());
+    static_cast<S *>(this)->continuations().push(std::move(cnt),
+                                                 get_allocator());
   }
 
 private:
+  using state_allocator = typename std::allocator_traits<
+      Alloc>::template rebind_alloc<allocated_state>;
+  using state_traits = std::allocator_traits<state_allocator>;
+
+  void destroy() noexcept override {
+    state_allocator alloc{std::move(get_allocator())};
+    state_traits::destroy(alloc, this);
+    state_traits::deallocate(alloc, this, 1);
+  }
+
   Alloc &get_allocator() { return *this; }
 };
 
+template <typename S, typename Alloc, typename... A>
+state_ptr<S> allocate_state(const Alloc &allocator, A &&...a) {
+  return allocated_state<S, Alloc>::make(allocator, std::forward<A>(a)...);
+}
+
+// Default allocator is stateless so there is nothing to carry in the state
+template <typename S, typename T, typename... A>
+state_ptr<S> allocate_state(const std::allocator<T> &, A &&...a) {
+  return make_state<S>(std::forward<A>(a)...);
+}
+
+template <typename Alloc>
+void push_continuation(future_state_base &state, continuation &&cnt,
+                       const Alloc &allocator) {
+  state.continuations().push(std::move(cnt), allocator);
+}
+
+template <typename T>
+void push_continuation(future_state_base &state, continuation &&cnt,
+                       const std::allocator<T> &) {
+  state.push(std::move(cnt));
+}
+
 } // namespace detail
 } // namespace cxx14_v1
 } // namespace portable_concurrency
@@ -7,17 +7,30 @@ namespace portable_concurrency {
 inline namespace cxx14_v1 {
 namespace detail {
 
+#if defined(PC_SMALL_BUFFER_SIZE)
+constexpr size_t small_buffer_size = PC_SMALL_BUFFER_SIZE;
+#else
 constexpr size_t small_buffer_size = 5 * sizeof(void *);
+#endif
 constexpr size_t small_buffer_align = alignof(void *);
-using small_buffer =
-    std::aligned_storage_t<small_buffer_size, small_buffer_align>;
+
+// Library internals rely on the ability to store continuations and tasks
+// capturing up to 5 pointers without allocation.
+static_assert(small_buffer_size >= 5 * sizeof(void *),
+              "PC_SMALL_BUFFER_SIZE must be at least 5 * sizeof(void *)");
+
+template <size_t Size, size_t Align>
+using small_buffer = std::aligned_storage_t<Size, Align>;
 
 template <typename R, typename... A> struct callable_vtbl;
 
-template <typename S> class small_unique_function;
+template <typename S, size_t Size = small_buffer_size,
+          size_t Align = small_buffer_align>
+class small_unique_function;
 
 // Move-only type erasure for small NothrowMoveConstructible Callable object.
-template <typename R, typename... A> class small_unique_function<R(A...)> {
+template <typename R, typename... A, size_t Size, size_t Align>
+class small_unique_function<R(A...), Size, Align> {
 public:
   small_unique_function() noexcept;
   small_unique_function(std::nullptr_t) noexcept;
@@ -38,7 +51,10 @@ public:
   explicit operator bool() const noexcept { return vtbl_ != nullptr; }
 
 private:
-  mutable small_buffer buffer_;
+  void relocate(small_unique_function &rhs) noexcept;
+
+private:
+  mutable small_buffer<Size, Align> buffer_;
   const callable_vtbl<R, A...> *vtbl_ = nullptr;
 };
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstring>
 #include <type_traits>
 
 #include "invoke.h"
@@ -19,42 +20,69 @@ template <typename F>
 using is_storable_helper =
     std::conditional_t<std::is_function<F>::value, F *, F>;
 
-template <typename F>
+template <typename F, size_t Size = small_buffer_size,
+          size_t Align = small_buffer_align>
 using is_storable_t = std::integral_constant<
-    bool, alignof(is_storable_helper<F>) <= small_buffer_align &&
-              sizeof(is_storable_helper<F>) <= small_buffer_size &&
+    bool, alignof(is_storable_helper<F>) <= Align &&
+              sizeof(is_storable_helper<F>) <= Size &&
               std::is_nothrow_move_constructible<F>::value>;
 
 template <typename R, typename... A> using func_ptr_t = R (*)(A...);
 
+// Buffer size independent so that functions with different buffer sizes
+// storing the same callable type share single table.
+//
+// Trivially copyable callables (function pointers, lambdas capturing pointers
+// or integers) are relocated by copying the buffer bytes and need no
+// destruction. Such callables have null `destroy` and `move` entries.
 template <typename R, typename... A> struct callable_vtbl {
-  func_ptr_t<void, small_buffer &> destroy;
-  func_ptr_t<void, small_buffer &, small_buffer &> move;
-  func_ptr_t<R, small_buffer &, A...> call;
+  func_ptr_t<void, void *> destroy;
+  func_ptr_t<void, void *, void *> move;
+  func_ptr_t<R, void *, A...> call;
 };
 
+template <typename F>
+using is_trivially_relocatable = std::is_trivially_copyable<F>;
+
+template <typename F>
+func_ptr_t<void, void *> get_destroy(std::false_type) {
+  return [](void *buf) { static_cast<F *>(buf)->~F(); };
+}
+
+template <typename F> func_ptr_t<void, void *> get_destroy(std::true_type) {
+  return nullptr;
+}
+
+template <typename F>
+func_ptr_t<void, void *, void *> get_move(std::false_type) {
+  return [](void *src, void *dst) {
+    new (dst) F{std::move(*static_cast<F *>(src))};
+  };
+}
+
+template <typename F>
+func_ptr_t<void, void *, void *> get_move(std::true_type) {
+  return nullptr;
+}
+
 template <typename F, typename R, typename... A>
 const callable_vtbl<R, A...> &get_callable_vtbl() {
-  static_assert(is_storable_t<F>::value,
-                "Can't embed object into small buffer");
   static const callable_vtbl<R, A...> res = {
-      [](small_buffer &buf) { reinterpret_cast<F &>(buf).~F(); },
-      [](small_buffer &src, small_buffer &dst) {
-        new (&dst) F{std::move(reinterpret_cast<F &>(src))};
-      },
-      [](small_buffer &buf, A... a) -> R {
+      get_destroy<F>(is_trivially_relocatable<F>{}),
+      get_move<F>(is_trivially_relocatable<F>{}),
+      [](void *buf, A... a) -> R {
 #if !defined(_MSC_VER)
         // Must not perform conversions marked as explicit but must cast
         // anything to `void` if `R` is `void`
         return static_cast<std::conditional_t<
             std::is_void<R>::value, void,
             decltype(portable_concurrency::cxx14_v1::detail::invoke(
-                reinterpret_cast<F &>(buf), std::forward<A>(a)...))>>(
+                *static_cast<F *>(buf), std::forward<A>(a)...))>>(
             portable_concurrency::cxx14_v1::detail::invoke(
-                reinterpret_cast<F &>(buf), std::forward<A>(a)...));
+                *static_cast<F *>(buf), std::forward<A>(a)...));
 #else
         return static_cast<R>(portable_concurrency::cxx14_v1::detail::invoke(
-            reinterpret_cast<F &>(buf), std::forward<A>(a)...));
+            *static_cast<F *>(buf), std::forward<A>(a)...));
 #endif
       }};
   return res;
@@ -88,17 +116,18 @@ auto is_null(const T &val) noexcept
 #pragma GCC diagnostic pop
 #endif
 
-template <typename R, typename... A>
-small_unique_function<R(A...)>::small_unique_function() noexcept = default;
+template <typename R, typename... A, size_t Size, size_t Align>
+small_unique_function<R(A...), Size, Align>::small_unique_function() noexcept =
+    default;
 
-template <typename R, typename... A>
-small_unique_function<R(A...)>::small_unique_function(std::nullptr_t) noexcept {
-}
+template <typename R, typename... A, size_t Size, size_t Align>
+small_unique_function<R(A...), Size, Align>::small_unique_function(
+    std::nullptr_t) noexcept {}
 
-template <typename R, typename... A>
+template <typename R, typename... A, size_t Size, size_t Align>
 template <typename F>
-small_unique_function<R(A...)>::small_unique_function(F &&f) {
-  static_assert(is_storable_t<std::decay_t<F>>::value,
+small_unique_function<R(A...), Size, Align>::small_unique_function(F &&f) {
+  static_assert(is_storable_t<std::decay_t<F>, Size, Align>::value,
                 "Can't embed object into small_unique_function");
   if (detail::is_null(f))
     return;
@@ -106,36 +135,45 @@ small_unique_function<R(A...)>::small_unique_function(F &&f) {
   vtbl_ = &detail::get_callable_vtbl<std::decay_t<F>, R, A...>();
 }
 
-template <typename R, typename... A>
-small_unique_function<R(A...)>::~small_unique_function() {
-  if (vtbl_)
-    vtbl_->destroy(buffer_);
+template <typename R, typename... A, size_t Size, size_t Align>
+small_unique_function<R(A...), Size, Align>::~small_unique_function() {
+  if (vtbl_ && vtbl_->destroy)
+    vtbl_->destroy(&buffer_);
 }
 
-template <typename R, typename... A>
-small_unique_function<R(A...)>::small_unique_function(
-    small_unique_function<R(A...)> &&rhs) noexcept {
-  if (rhs.vtbl_)
-    rhs.vtbl_->move(rhs.buffer_, buffer_);
-  vtbl_ = rhs.vtbl_;
+template <typename R, typename... A, size_t Size, size_t Align>
+small_unique_function<R(A...), Size, Align>::small_unique_function(
+    small_unique_function &&rhs) noexcept {
+  relocate(rhs);
 }
 
-template <typename R, typename... A>
-small_unique_function<R(A...)> &small_unique_function<R(A...)>::operator=(
-    small_unique_function<R(A...)> &&rhs) noexcept {
-  if (vtbl_)
-    vtbl_->destroy(buffer_);
-  if (rhs.vtbl_)
-    rhs.vtbl_->move(rhs.buffer_, buffer_);
-  vtbl_ = rhs.vtbl_;
+template <typename R, typename... A, size_t Size, size_t Align>
+small_unique_function<R(A...), Size, Align> &
+small_unique_function<R(A...), Size, Align>::operator=(
+    small_unique_function &&rhs) noexcept {
+  if (vtbl_ && vtbl_->destroy)
+    vtbl_->destroy(&buffer_);
+  relocate(rhs);
   return *this;
 }
 
-template <typename R, typename... A>
-R small_unique_function<R(A...)>::operator()(A... args) const {
+template <typename R, typename... A, size_t Size, size_t Align>
+void small_unique_function<R(A...), Size, Align>::relocate(
+    small_unique_function &rhs) noexcept {
+  vtbl_ = rhs.vtbl_;
+  if (!vtbl_)
+    return;
+  if (vtbl_->move)
+    vtbl_->move(&rhs.buffer_, &buffer_);
+  else
+    std::memcpy(&buffer_, &rhs.buffer_, sizeof(buffer_));
+}
+
+template <typename R, typename... A, size_t Size, size_t Align>
+R small_unique_function<R(A...), Size, Align>::operator()(A... args) const {
   if (!vtbl_)
     throw_bad_func_call();
-  return vtbl_->call(buffer_, std::forward<A>(args)...);
+  return vtbl_->call(&buffer_, std::forward<A>(args)...);
 }
 
 } // namespace detail
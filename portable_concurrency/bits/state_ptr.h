@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+namespace detail {
+
+struct adopt_ref_t {};
+constexpr adopt_ref_t adopt_ref = {};
+
+/**
+ * @internal
+ *
+ * Strong reference to the intrusively reference counted shared state. Owning
+ * at least one strong reference keeps the state and all of the objects owned
+ * by it alive.
+ */
+template <typename S> class state_ptr {
+public:
+  state_ptr() noexcept = default;
+  state_ptr(std::nullptr_t) noexcept {}
+  // Takes ownership of the reference already counted in the state
+  state_ptr(S *ptr, adopt_ref_t) noexcept : ptr_{ptr} {}
+  explicit state_ptr(S *ptr) noexcept : ptr_{ptr} {
+    if (ptr_)
+      ptr_->add_ref();
+  }
+
+  state_ptr(const state_ptr &rhs) noexcept : state_ptr{rhs.ptr_} {}
+  state_ptr(state_ptr &&rhs) noexcept : ptr_{rhs.release()} {}
+
+  template <typename U, typename = std::enable_if_t<
+                            std::is_convertible<U *, S *>::value>>
+  state_ptr(const state_ptr<U> &rhs) noexcept : state_ptr{rhs.get()} {}
+  template <typename U, typename = std::enable_if_t<
+                            std::is_convertible<U *, S *>::value>>
+  state_ptr(state_ptr<U> &&rhs) noexcept : ptr_{rhs.release()} {}
+
+  ~state_ptr() {
+    if (ptr_)
+      ptr_->release();
+  }
+
+  state_ptr &operator=(state_ptr rhs) noexcept {
+    std::swap(ptr_, rhs.ptr_);
+    return *this;
+  }
+
+  S *get() const noexcept { return ptr_; }
+  S &operator*() const noexcept { return *ptr_; }
+  S *operator->() const noexcept { return ptr_; }
+  explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+  // Returns the pointer without decrementing the reference counter
+  S *release() noexcept { return std::exchange(ptr_, nullptr); }
+
+private:
+  S *ptr_ = nullptr;
+};
+
+/**
+ * @internal
+ *
+ * Weak reference to the intrusively reference counted shared state. Keeps the
+ * memory occupied by the state but not the objects owned by it. Used by the
+ * producers of the value which should not prolong the lifetime of the value
+ * nobody waits for.
+ */
+template <typename S> class weak_state_ptr {
+public:
+  weak_state_ptr() noexcept = default;
+  weak_state_ptr(std::nullptr_t) noexcept {}
+  // Takes ownership of the weak reference already counted in the state
+  weak_state_ptr(S *ptr, adopt_ref_t) noexcept : ptr_{ptr} {}
+
+  template <typename U, typename = std::enable_if_t<
+                            std::is_convertible<U *, S *>::value>>
+  weak_state_ptr(const state_ptr<U> &rhs) noexcept : ptr_{rhs.get()} {
+    if (ptr_)
+      ptr_->add_weak_ref();
+  }
+  template <typename U, typename = std::enable_if_t<
+                            std::is_convertible<U *, S *>::value>>
+  weak_state_ptr(state_ptr<U> &&rhs) noexcept : ptr_{rhs.get()} {
+    if (ptr_)
+      ptr_->add_weak_ref();
+    rhs = nullptr;
+  }
+
+  weak_state_ptr(const weak_state_ptr &rhs) noexcept : ptr_{rhs.ptr_} {
+    if (ptr_)
+      ptr_->add_weak_ref();
+  }
+  weak_state_ptr(weak_state_ptr &&rhs) noexcept
+      : ptr_{std::exchange(rhs.ptr_, nullptr)} {}
+
+  template <typename U, typename = std::enable_if_t<
+                            std::is_convertible<U *, S *>::value>>
+  weak_state_ptr(weak_state_ptr<U> &&rhs) noexcept : ptr_{rhs.ptr_} {
+    rhs.ptr_ = nullptr;
+  }
+
+  ~weak_state_ptr() {
+    if (ptr_)
+      ptr_->release_weak();
+  }
+
+  weak_state_ptr &operator=(weak_state_ptr rhs) noexcept {
+    std::swap(ptr_, rhs.ptr_);
+    return *this;
+  }
+
+  state_ptr<S> lock() const noexcept {
+    if (ptr_ && ptr_->try_add_ref())
+      return {ptr_, adopt_ref};
+    return nullptr;
+  }
+
+  bool expired() const noexcept { return !ptr_ || ptr_->expired(); }
+
+  // Pointer to the state which might be already disposed. Only the members
+  // which are not released by the state `dispose` function can be accessed.
+  S *get() const noexcept { return ptr_; }
+
+  // Returns the pointer without decrementing the weak reference counter
+  S *release() noexcept { return std::exchange(ptr_, nullptr); }
+
+private:
+  template <typename U> friend class weak_state_ptr;
+
+  S *ptr_ = nullptr;
+};
+
+template <typename S, typename... A> state_ptr<S> make_state(A &&...a) {
+  return {new S(std::forward<A>(a)...), adopt_ref};
+}
+
+} // namespace detail
+} // namespace cxx14_v1
+} // namespace portable_concurrency
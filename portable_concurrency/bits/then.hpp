@@ -12,7 +12,7 @@ inline namespace cxx14_v1 {
 namespace detail {
 
 // Decorate different functors in order to be callable as
-// `decorated_func(shared_ptr<shared_state<R>>, shared_ptr<future_state<T>>);`
+// `decorated_func(state_ptr<shared_state<R>>, state_ptr<future_state<T>>);`
 
 namespace this_ns = ::portable_concurrency::cxx14_v1::detail;
 
@@ -29,22 +29,22 @@ using UnwrappableContinuation =
 
 template <typename R, typename T, typename F>
 auto decorate_unique_then(DirectContinuation<F, future<T>> &&f,
-                          std::shared_ptr<future_state<T>> &&parent) {
+                          state_ptr<future_state<T>> &&parent) {
   return [f = std::forward<F>(f), parent = std::move(parent)](
-             std::shared_ptr<shared_state<R>> &&state) mutable {
+             state_ptr<shared_state<R>> &&state) mutable {
     set_state_value(state, std::move(f), future<T>{std::move(parent)});
   };
 }
 
 template <typename R, typename T, typename F>
 auto decorate_unique_then(UnwrappableContinuation<F, future<T>> &&f,
-                          std::shared_ptr<future_state<T>> &&parent) {
+                          state_ptr<future_state<T>> &&parent) {
   return [f = std::forward<F>(f), parent = std::move(parent)](
-             std::shared_ptr<shared_state<R>> &&state) mutable {
+             state_ptr<shared_state<R>> &&state) mutable {
     try {
       shared_state<R>::unwrap(
-          state, state_of(this_ns::invoke(std::move(f),
-                                          future<T>{std::move(parent)})));
+          state,
+          this_ns::invoke(std::move(f), future<T>{std::move(parent)}));
     } catch (...) {
       state->set_exception(std::current_exception());
     }
@@ -53,24 +53,24 @@ auto decorate_unique_then(UnwrappableContinuation<F, future<T>> &&f,
 
 template <typename R, typename T, typename F>
 auto decorate_shared_then(DirectContinuation<F, shared_future<T>> &&f,
-                          const std::shared_ptr<future_state<T>> &parent) {
+                          const state_ptr<future_state<T>> &parent) {
   return [f = std::forward<F>(f),
-          parent = std::shared_ptr<future_state<T>>{parent}](
-             std::shared_ptr<shared_state<R>> &&state) mutable {
+          parent = state_ptr<future_state<T>>{parent}](
+             state_ptr<shared_state<R>> &&state) mutable {
     set_state_value(state, std::move(f), shared_future<T>{std::move(parent)});
   };
 }
 
 template <typename R, typename T, typename F>
 auto decorate_shared_then(UnwrappableContinuation<F, shared_future<T>> &&f,
-                          const std::shared_ptr<future_state<T>> &parent) {
+                          const state_ptr<future_state<T>> &parent) {
   return [f = std::forward<F>(f),
-          parent = std::shared_ptr<future_state<T>>{parent}](
-             std::shared_ptr<shared_state<R>> &&state) mutable {
+          parent = state_ptr<future_state<T>>{parent}](
+             state_ptr<shared_state<R>> &&state) mutable {
     try {
       shared_state<R>::unwrap(
-          state, state_of(this_ns::invoke(
-                     std::move(f), shared_future<T>{std::move(parent)})));
+          state,
+          this_ns::invoke(std::move(f), shared_future<T>{std::move(parent)}));
     } catch (...) {
       state->set_exception(std::current_exception());
     }
@@ -79,9 +79,9 @@ auto decorate_shared_then(UnwrappableContinuation<F, shared_future<T>> &&f,
 
 template <typename R, typename T, typename F>
 auto decorate_unique_next(DirectContinuation<F, T> &&f,
-                          std::shared_ptr<future_state<T>> &&parent) {
+                          state_ptr<future_state<T>> &&parent) {
   return [f = std::forward<F>(f), parent = std::move(parent)](
-             std::shared_ptr<shared_state<R>> &&state) mutable {
+             state_ptr<shared_state<R>> &&state) mutable {
     if (auto error = parent->exception()) {
       state->set_exception(std::move(error));
       return;
@@ -92,17 +92,17 @@ auto decorate_unique_next(DirectContinuation<F, T> &&f,
 
 template <typename R, typename T, typename F>
 auto decorate_unique_next(UnwrappableContinuation<F, T> &&f,
-                          std::shared_ptr<future_state<T>> &&parent) {
+                          state_ptr<future_state<T>> &&parent) {
   return [f = std::forward<F>(f), parent = std::move(parent)](
-             std::shared_ptr<shared_state<R>> &&state) mutable {
+             state_ptr<shared_state<R>> &&state) mutable {
     if (auto error = parent->exception()) {
       state->set_exception(std::move(error));
       return;
     }
     try {
       shared_state<R>::unwrap(
-          state, state_of(this_ns::invoke(std::move(f),
-                                          std::move(parent->value_ref()))));
+          state,
+          this_ns::invoke(std::move(f), std::move(parent->value_ref())));
     } catch (...) {
       state->set_exception(std::current_exception());
     }
@@ -111,9 +111,9 @@ auto decorate_unique_next(UnwrappableContinuation<F, T> &&f,
 
 template <typename R, typename T, typename F>
 auto decorate_shared_next(DirectContinuation<F, cref_t<T>> &&f,
-                          const std::shared_ptr<future_state<T>> &parent) {
+                          const state_ptr<future_state<T>> &parent) {
   return [f = std::forward<F>(f),
-          parent](std::shared_ptr<shared_state<R>> &&state) mutable {
+          parent](state_ptr<shared_state<R>> &&state) mutable {
     if (auto error = parent->exception()) {
       state->set_exception(std::move(error));
       return;
@@ -125,9 +125,9 @@ auto decorate_shared_next(DirectContinuation<F, cref_t<T>> &&f,
 
 template <typename R, typename T, typename F>
 auto decorate_shared_next(UnwrappableContinuation<F, cref_t<T>> &&f,
-                          const std::shared_ptr<future_state<T>> &parent) {
+                          const state_ptr<future_state<T>> &parent) {
   return [f = std::forward<F>(f),
-          parent](std::shared_ptr<shared_state<R>> &&state) mutable {
+          parent](state_ptr<shared_state<R>> &&state) mutable {
     if (auto error = parent->exception()) {
       state->set_exception(std::move(error));
       return;
@@ -135,8 +135,8 @@ auto decorate_shared_next(UnwrappableContinuation<F, cref_t<T>> &&f,
     try {
       shared_state<R>::unwrap(
           state,
-          state_of(this_ns::invoke(
-              std::move(f), static_cast<cref_t<T>>(parent->value_ref()))));
+          this_ns::invoke(std::move(f),
+                          static_cast<cref_t<T>>(parent->value_ref())));
     } catch (...) {
       state->set_exception(std::current_exception());
     }
@@ -145,9 +145,9 @@ auto decorate_shared_next(UnwrappableContinuation<F, cref_t<T>> &&f,
 
 template <typename R, typename F>
 auto decorate_void_next(DirectContinuation<F, void> &&f,
-                        std::shared_ptr<future_state<void>> parent) {
+                        state_ptr<future_state<void>> parent) {
   return [f = std::forward<F>(f), parent = std::move(parent)](
-             std::shared_ptr<shared_state<R>> &&state) mutable {
+             state_ptr<shared_state<R>> &&state) mutable {
     if (auto error = parent->exception()) {
       state->set_exception(std::move(error));
       return;
@@ -158,37 +158,92 @@ auto decorate_void_next(DirectContinuation<F, void> &&f,
 
 template <typename R, typename F>
 auto decorate_void_next(UnwrappableContinuation<F, void> &&f,
-                        std::shared_ptr<future_state<void>> parent) {
+                        state_ptr<future_state<void>> parent) {
   return [f = std::forward<F>(f), parent = std::move(parent)](
-             std::shared_ptr<shared_state<R>> &&state) mutable {
+             state_ptr<shared_state<R>> &&state) mutable {
     if (auto error = parent->exception()) {
       state->set_exception(std::move(error));
       return;
     }
     try {
-      shared_state<R>::unwrap(state, state_of(this_ns::invoke(std::move(f))));
+      shared_state<R>::unwrap(state, this_ns::invoke(std::move(f)));
     } catch (...) {
       state->set_exception(std::current_exception());
     }
   };
 }
 
+// eager execution of continuations attached to ready futures with
+// inplace_executor
+
+template <typename E>
+using is_inplace_executor = std::is_same<std::decay_t<E>, inplace_executor_t>;
+
+// Result of the continuation can be stored in the ready future object
+template <typename R, typename Res>
+using eager_inline_result =
+    std::integral_constant<bool, stored_inline<R>::value &&
+                                     !is_shared_future<Res>::value>;
+
+template <typename R, typename F, typename... A>
+std::enable_if_t<std::is_void<invoke_result_t<F, A...>>::value, future<R>>
+invoke_inline(F &&f, A &&...a) {
+  this_ns::invoke(std::forward<F>(f), std::forward<A>(a)...);
+  return ready_value_t<R>{in_place_index_t<1>{}};
+}
+
+template <typename R, typename F, typename... A>
+std::enable_if_t<!std::is_void<invoke_result_t<F, A...>>::value &&
+                     !is_future<invoke_result_t<F, A...>>::value,
+                 future<R>>
+invoke_inline(F &&f, A &&...a) {
+  return ready_value_t<R>{
+      in_place_index_t<1>{},
+      this_ns::invoke(std::forward<F>(f), std::forward<A>(a)...)};
+}
+
+template <typename R, typename F, typename... A>
+std::enable_if_t<is_unique_future<invoke_result_t<F, A...>>::value, future<R>>
+invoke_inline(F &&f, A &&...a) {
+  future<R> res = this_ns::invoke(std::forward<F>(f), std::forward<A>(a)...);
+  if (!res.valid())
+    return ready_value_t<R>{in_place_index_t<2>{}, make_broken_promise()};
+  return res;
+}
+
+template <typename R, typename Alloc, typename F, typename... A>
+future<R> run_eagerly(std::true_type, const Alloc &, F &&f, A &&...a) {
+  try {
+    return invoke_inline<R>(std::forward<F>(f), std::forward<A>(a)...);
+  } catch (...) {
+    return ready_value_t<R>{in_place_index_t<2>{}, std::current_exception()};
+  }
+}
+
+template <typename R, typename Alloc, typename F, typename... A>
+future<R> run_eagerly(std::false_type, const Alloc &allocator, F &&f,
+                      A &&...a) {
+  auto state = allocate_state<shared_state<R>>(allocator);
+  set_state_value(state, std::forward<F>(f), std::forward<A>(a)...);
+  return {std::move(state)};
+}
+
 // continuation state
 
 template <typename CntState> struct cnt_action {
-  std::weak_ptr<CntState> wdata;
+  weak_state_ptr<CntState> wdata;
 
   cnt_action(const cnt_action &) = delete;
   cnt_action &operator=(const cnt_action &) = delete;
 
-  cnt_action(std::weak_ptr<CntState> wdata) : wdata(std::move(wdata)) {}
+  cnt_action(weak_state_ptr<CntState> wdata) : wdata(std::move(wdata)) {}
   cnt_action(cnt_action &&rhs) noexcept : wdata(std::move(rhs.wdata)) {}
   cnt_action &operator=(cnt_action &&rhs) noexcept {
     wdata = std::move(rhs.wdata);
     return *this;
   }
 
-  void operator()() { CntState::run(std::exchange(wdata, {})); }
+  void operator()() { CntState::run(std::exchange(wdata, nullptr)); }
 
   ~cnt_action() {
     if (auto data = wdata.lock())
@@ -196,50 +251,63 @@ template <typename CntState> struct cnt_action {
   }
 };
 
-template <typename R, typename F, typename E> struct cnt_state {
+template <typename R, typename F, typename E>
+class cnt_state : public shared_state<R> {
+public:
+  template <typename UE, typename UF>
+  cnt_state(UE &&exec, UF &&func)
+      : exec_{in_place_index_t<1>{}, std::forward<UE>(exec)},
+        action_{in_place_index_t<1>{}, std::forward<UF>(func)} {}
+
   void abandon() {
-    state.abandon();
-    action.clean();
+    shared_state<R>::abandon();
+    action_.clean();
   }
 
-  static void run(std::weak_ptr<cnt_state> wself) noexcept {
-    std::shared_ptr<cnt_state> self = wself.lock();
+  static void run(weak_state_ptr<cnt_state> wself) noexcept {
+    state_ptr<cnt_state> self = wself.lock();
     if (!self)
       return;
-    F func = std::move(self->action.get(in_place_index_t<1>{}));
-    self->action.clean();
-    shared_state<R> *state = &self->state;
-    std::shared_ptr<shared_state<R>> state_sp{std::exchange(self, nullptr),
-                                              state};
-    func(std::move(state_sp));
+    F func = std::move(self->action_.get(in_place_index_t<1>{}));
+    self->action_.clean();
+    func(state_ptr<shared_state<R>>{std::move(self)});
   }
 
-  static void schedule(std::weak_ptr<cnt_state> wself) {
-    auto self = wself.lock();
-    if (!self)
+  // Executor is never touched by the dispose function and can be accessed via
+  // weak reference without locking the state.
+  static void schedule(weak_state_ptr<cnt_state> wself) {
+    if (wself.expired())
       return;
-    E exec = std::move(self->exec.get(in_place_index_t<1>{}));
-    self->exec.clean();
-    std::weak_ptr<cnt_state> wstate = std::exchange(self, nullptr);
-    post(exec, cnt_action<cnt_state>{std::move(wstate)});
+    auto &exec_storage = wself.get()->exec_;
+    E exec = std::move(exec_storage.get(in_place_index_t<1>{}));
+    exec_storage.clean();
+    post(exec, cnt_action<cnt_state>{std::move(wself)});
+  }
+
+private:
+  void dispose() noexcept override {
+    action_.clean();
+    shared_state<R>::dispose();
   }
 
-  either<detail::monostate, E> exec;
-  either<detail::monostate, F> action;
-  shared_state<R> state;
+private:
+  either<detail::monostate, E> exec_;
+  either<detail::monostate, F> action_;
 };
 
-template <typename R, typename E, typename F>
-auto make_then_state(continuations_stack &subscriptions, E &&exec, F &&f) {
+template <typename R, typename Alloc, typename E, typename F>
+auto make_then_state(future_state_base &parent, const Alloc &allocator,
+                     E &&exec, F &&f) {
   using cnt_data_t = cnt_state<R, std::decay_t<F>, std::decay_t<E>>;
 
-  auto data = std::make_shared<cnt_data_t>();
-  data->exec.emplace(in_place_index_t<1>{}, std::forward<E>(exec));
-  data->action.emplace(in_place_index_t<1>{}, std::forward<F>(f));
-  subscriptions.push([wdata = std::weak_ptr<cnt_data_t>{data}] {
-    cnt_data_t::schedule(wdata);
-  });
-  return std::shared_ptr<future_state<R>>{data, &data->state};
+  auto data = allocate_state<cnt_data_t>(allocator, std::forward<E>(exec),
+                                         std::forward<F>(f));
+  push_continuation(parent,
+                    [wdata = weak_state_ptr<cnt_data_t>{data}]() mutable {
+                      cnt_data_t::schedule(std::move(wdata));
+                    },
+                    allocator);
+  return state_ptr<future_state<R>>{std::move(data)};
 }
 
 } // namespace detail
@@ -0,0 +1,1152 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "blocking_observer.h"
+#include "closable_queue.hpp"
+#include "cpu_relax.h"
+#include "event_count.h"
+#include "injection_queue.h"
+#include "mpmc_queue.h"
+#include "thread_pool.h"
+#include "unique_function.hpp"
+#include "work_stealing_deque.h"
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+namespace detail {
+
+template class closable_queue<unique_function<void()>>;
+
+class thread_pool_core {
+public:
+  thread_pool_core(const thread_pool_options &options, std::size_t workers);
+  ~thread_pool_core();
+
+  thread_pool_core(const thread_pool_core &) = delete;
+  thread_pool_core &operator=(const thread_pool_core &) = delete;
+
+  void post(priority prio, unique_function<void()> &&task);
+  void post_bulk(priority prio, unique_function<void()> *tasks,
+                 std::size_t count);
+  void post_to_node(unsigned node, unique_function<void()> &&task);
+  void post_to_worker(std::size_t worker, unique_function<void()> &&task);
+
+  // Process tasks on the calling thread until the pool is stopped or closed
+  // and all of the queued tasks are processed. Calling thread becomes the
+  // worker with the index specified if it is one of created with the pool or
+  // a new worker otherwise.
+  void run(std::size_t worker) noexcept;
+
+  bool has_node(unsigned node) const noexcept;
+  bool has_worker(std::size_t worker) const noexcept;
+  thread_pool_stats stats();
+
+  // Stop accepting new tasks
+  void close();
+  // Stop accepting new tasks and abandon queued ones
+  void stop();
+
+private:
+  struct task_node {
+    unique_function<void()> func;
+    std::atomic<task_node *> next{nullptr};
+  };
+
+  struct worker final : blocking_observer {
+    using histogram = std::array<std::atomic<std::uint64_t>,
+                                 std::tuple_size<decltype(
+                                     duration_histogram::buckets)>::value>;
+
+    worker(thread_pool_core *owner, std::size_t index, unsigned node,
+           std::uint32_t seed)
+        : owner{owner}, index{index}, node{node}, rng_state{seed} {}
+
+    ~worker() { delete spare_node; }
+
+    // Task in the LIFO slot of a blocked worker is handed over to the others
+    void blocking_started() noexcept override {
+      blocked.store(true, std::memory_order_seq_cst);
+      if (lifo_slot.load(std::memory_order_seq_cst))
+        owner->wake_worker();
+    }
+
+    void blocking_finished() noexcept override {
+      blocked.store(false, std::memory_order_relaxed);
+    }
+
+    // xorshift32
+    std::uint32_t random() noexcept {
+      rng_state ^= rng_state << 13;
+      rng_state ^= rng_state >> 17;
+      rng_state ^= rng_state << 5;
+      return rng_state;
+    }
+
+    thread_pool_core *const owner;
+    const std::size_t index;
+    const unsigned node;
+    // Tasks posted via worker_executor
+    injection_queue<task_node> targeted;
+    // Idle worker parks here so that tasks which only this worker or the
+    // workers of its node may run wake up nobody else
+    event_count parking;
+    // Task to be executed next by this worker. Can be taken by other workers
+    // while this one is blocked or doesn't start new tasks for too long.
+    std::atomic<task_node *> lifo_slot{nullptr};
+    std::atomic<bool> blocked{false};
+    // Number of tasks started by this worker. Written by the owner only.
+    std::atomic<std::uint64_t> started{0};
+    work_stealing_deque<task_node> tasks;
+
+    // Statistics. Written by the owner only.
+    std::atomic<std::uint64_t> steals{0};
+    std::atomic<std::int64_t> busy_ns{0};
+    std::atomic<std::int64_t> idle_ns{0};
+    histogram queue_latency{};
+    histogram execution_time{};
+
+    // Owner only
+    task_node *spare_node = nullptr;
+    unsigned lifo_chain = 0;
+    unsigned tick = 0;
+    std::uint32_t rng_state;
+    unsigned searches = 0;
+    std::chrono::steady_clock::time_point last_finish;
+    // LIFO slot of a busy worker watched by this one while idle. Its task is
+    // taken once the owner doesn't start any other task for the steal delay.
+    const worker *watched = nullptr;
+    const task_node *watched_task = nullptr;
+    std::uint64_t watched_started = 0;
+    std::chrono::steady_clock::time_point watched_since;
+  };
+
+  worker &register_worker();
+  worker *current_worker() const noexcept;
+  bool post_to_lifo_slot(worker &self, unique_function<void()> &task);
+  void post(unique_function<void()> &&task);
+  void post_bulk(unique_function<void()> *tasks, std::size_t count);
+  injection_queue<task_node> &priority_queue(priority prio) noexcept;
+  bool find_task(worker &self, unique_function<void()> &task);
+  bool find_regular_task(worker &self, unique_function<void()> &task);
+  bool search_task(worker &self, unique_function<void()> &task);
+  task_node *find_queued_task(worker &self);
+  task_node *steal(worker &self);
+  task_node *steal_lifo_slot(worker &self, bool &watching);
+  task_node *find_targeted_task(worker &self);
+  bool has_pending_tasks(const worker &self) const noexcept;
+  void cancel_park(worker &self) noexcept;
+  template <typename P> bool wake_parked(P &&eligible) noexcept;
+  void wake_worker() noexcept;
+  void wake_workers(std::size_t count) noexcept;
+
+  void execute(worker &self, unique_function<void()> &task);
+  void stamp(unique_function<void()> &task);
+  task_node *make_node(worker *self, unique_function<void()> &&task);
+  static void push_chain(injection_queue<task_node> &queue,
+                         unique_function<void()> *tasks, std::size_t count);
+  bool take(worker &self, task_node *node,
+            unique_function<void()> &task) noexcept;
+  void recycle(worker &self, task_node *node) noexcept;
+  void abandon_if_closed() noexcept;
+  void abandon_queued_tasks() noexcept;
+  template <typename T>
+  static void add(std::atomic<T> &counter, T value) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+                  std::memory_order_relaxed);
+  }
+  static void record(worker::histogram &histogram,
+                     std::chrono::nanoseconds duration) noexcept;
+
+private:
+  static thread_local worker *current_;
+  static constexpr std::size_t max_free_nodes = 1024;
+
+  const thread_pool_options options_;
+  std::atomic<bool> closed_{false};
+  std::atomic<bool> stopped_{false};
+  // Number of threads inside of run including the pool threads not started yet
+  std::atomic<std::size_t> active_workers_;
+  // Number of abandon_queued_tasks calls not yet served by the thread which
+  // is abandoning tasks at the moment
+  std::atomic<unsigned> abandon_requests_{0};
+  // Number of idle workers spinning in search of a task
+  std::atomic<unsigned> searching_{0};
+  // Number of idle workers waiting for the LIFO slot steal delay to expire
+  std::atomic<unsigned> lifo_watchers_{0};
+  // Number of idle workers parking or parked. Allows posting threads to skip
+  // the scan of the workers list when nobody is parked.
+  std::atomic<unsigned> parked_{0};
+
+  // thread_pool_scheduling::shared_queue
+  closable_queue<unique_function<void()>> queue_;
+
+  // thread_pool_scheduling::lock_free_queue
+  mpmc_queue<unique_function<void()>> ring_{1024, true};
+
+  // Nodes released by workers and reused by the posting threads. Together with
+  // the small buffer of unique_function it makes posting of a continuation
+  // allocation free once the pool is warmed up.
+  injection_queue<task_node> free_nodes_;
+
+  // Tasks posted with priority::high and priority::low. Normal priority tasks
+  // are distributed according to the scheduling option.
+  injection_queue<task_node> high_tasks_;
+  injection_queue<task_node> low_tasks_;
+
+  // Tasks posted via node_executor
+  std::vector<std::unique_ptr<injection_queue<task_node>>> node_queues_;
+  // Number of workers created with the pool
+  const std::size_t pool_workers_;
+
+  // thread_pool_scheduling::work_stealing
+  injection_queue<task_node> injected_;
+  // Registration of a new worker is a rare event so thieves use immutable
+  // snapshot of the workers list which is replaced on each registration. Old
+  // snapshots are kept until the pool destruction.
+  std::atomic<const std::vector<worker *> *> victims_{nullptr};
+
+  std::mutex workers_mutex_;
+  std::vector<std::unique_ptr<worker>> workers_;
+  std::vector<std::unique_ptr<std::vector<worker *>>> victim_lists_;
+};
+
+thread_local thread_pool_core::worker *thread_pool_core::current_ = nullptr;
+
+thread_pool_core::thread_pool_core(const thread_pool_options &options,
+                                   std::size_t workers)
+    : options_(options), active_workers_(workers), pool_workers_(workers) {
+  unsigned nodes = 1;
+  for (unsigned node : options_.worker_nodes)
+    nodes = std::max(nodes, node + 1);
+  node_queues_.reserve(nodes);
+  while (node_queues_.size() < nodes)
+    node_queues_.push_back(std::make_unique<injection_queue<task_node>>());
+
+  // Workers of the pool threads are created upfront so that they are
+  // addressable by index before the threads start.
+  std::lock_guard<std::mutex> lock{workers_mutex_};
+  workers_.reserve(workers);
+  while (workers_.size() < workers)
+    register_worker();
+}
+
+thread_pool_core::~thread_pool_core() {
+  // Abandon tasks left in the queues after stop. Destruction of a task may
+  // post other tasks (broken promise notifications for example) which are
+  // dropped immediately since the pool is closed.
+  close();
+  abandon_queued_tasks();
+  while (task_node *node = free_nodes_.try_pop())
+    delete node;
+}
+
+void thread_pool_core::post(priority prio, unique_function<void()> &&task) {
+  stamp(task);
+  if (prio == priority::normal) {
+    post(std::move(task));
+    return;
+  }
+  if (closed_.load(std::memory_order_acquire))
+    return;
+  priority_queue(prio).push(make_node(current_worker(), std::move(task)));
+  abandon_if_closed();
+  wake_worker();
+}
+
+void thread_pool_core::post_bulk(priority prio, unique_function<void()> *tasks,
+                                 std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i)
+    stamp(tasks[i]);
+  if (prio == priority::normal) {
+    post_bulk(tasks, count);
+    return;
+  }
+  if (count == 0 || closed_.load(std::memory_order_acquire))
+    return;
+  push_chain(priority_queue(prio), tasks, count);
+  abandon_if_closed();
+  wake_workers(count);
+}
+
+void thread_pool_core::post(unique_function<void()> &&task) {
+  worker *self = current_worker();
+  if (self && post_to_lifo_slot(*self, task))
+    return;
+
+  switch (options_.scheduling) {
+  case thread_pool_scheduling::shared_queue:
+    queue_.push(std::move(task));
+    break;
+
+  case thread_pool_scheduling::lock_free_queue:
+    if (closed_.load(std::memory_order_acquire))
+      return;
+    ring_.try_push(std::move(task));
+    break;
+
+  case thread_pool_scheduling::work_stealing: {
+    if (closed_.load(std::memory_order_acquire))
+      return;
+    task_node *node = make_node(self, std::move(task));
+    if (self)
+      self->tasks.push(node);
+    else
+      injected_.push(node);
+  } break;
+  }
+  abandon_if_closed();
+  wake_worker();
+}
+
+void thread_pool_core::post_bulk(unique_function<void()> *tasks,
+                                 std::size_t count) {
+  if (count == 0)
+    return;
+  switch (options_.scheduling) {
+  case thread_pool_scheduling::shared_queue:
+    queue_.push(tasks, tasks + count);
+    break;
+
+  case thread_pool_scheduling::lock_free_queue:
+    if (closed_.load(std::memory_order_acquire))
+      return;
+    for (std::size_t i = 0; i < count; ++i)
+      ring_.try_push(std::move(tasks[i]));
+    break;
+
+  case thread_pool_scheduling::work_stealing: {
+    if (closed_.load(std::memory_order_acquire))
+      return;
+    worker *self = current_worker();
+    if (self) {
+      for (std::size_t i = 0; i < count; ++i)
+        self->tasks.push(make_node(self, std::move(tasks[i])));
+      break;
+    }
+    push_chain(injected_, tasks, count);
+  } break;
+  }
+  abandon_if_closed();
+  wake_workers(count);
+}
+
+// Link the nodes into a chain and publish it with a single exchange
+void thread_pool_core::push_chain(injection_queue<task_node> &queue,
+                                  unique_function<void()> *tasks,
+                                  std::size_t count) {
+  task_node *first = new task_node{std::move(tasks[0])};
+  task_node *last = first;
+  try {
+    for (std::size_t i = 1; i < count; ++i) {
+      task_node *node = new task_node{std::move(tasks[i])};
+      last->next.store(node, std::memory_order_relaxed);
+      last = node;
+    }
+  } catch (...) {
+    while (first)
+      delete std::exchange(first, first->next.load(std::memory_order_relaxed));
+    throw;
+  }
+  queue.push(first, last, count);
+}
+
+void thread_pool_core::post_to_node(unsigned node,
+                                    unique_function<void()> &&task) {
+  if (closed_.load(std::memory_order_acquire))
+    return;
+  stamp(task);
+  node_queues_[node]->push(make_node(current_worker(), std::move(task)));
+  abandon_if_closed();
+  // Searching workers may belong to some other node so they can't be relied
+  // upon to pick up this task.
+  wake_parked([node](const worker &w) { return w.node == node; });
+}
+
+void thread_pool_core::post_to_worker(std::size_t worker,
+                                      unique_function<void()> &&task) {
+  if (closed_.load(std::memory_order_acquire))
+    return;
+  stamp(task);
+  const std::vector<thread_pool_core::worker *> &workers =
+      *victims_.load(std::memory_order_acquire);
+  workers[worker]->targeted.push(
+      make_node(current_worker(), std::move(task)));
+  abandon_if_closed();
+  workers[worker]->parking.notify_one();
+}
+
+bool thread_pool_core::post_to_lifo_slot(worker &self,
+                                         unique_function<void()> &task) {
+  if (options_.lifo_slot_budget == 0)
+    return false;
+  if (closed_.load(std::memory_order_acquire))
+    return true;
+  task_node *displaced = self.lifo_slot.exchange(
+      make_node(&self, std::move(task)), std::memory_order_acq_rel);
+  if (!displaced) {
+    // Task in the slot is executed by its owner next unless the owner keeps
+    // running the current task for too long. Some idle worker has to watch
+    // for this to happen.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (lifo_watchers_.load(std::memory_order_relaxed) == 0)
+      wake_worker();
+    return true;
+  }
+  switch (options_.scheduling) {
+  case thread_pool_scheduling::shared_queue:
+    queue_.push(std::move(displaced->func));
+    recycle(self, displaced);
+    break;
+  case thread_pool_scheduling::lock_free_queue:
+    ring_.try_push(std::move(displaced->func));
+    recycle(self, displaced);
+    break;
+  case thread_pool_scheduling::work_stealing:
+    self.tasks.push(displaced);
+    break;
+  }
+  wake_worker();
+  return true;
+}
+
+// P0443R7 states that if task submitted to static_thread_pool exits via
+// exception then std::terminate is called. This behavior is established by
+// marking this function noexcept.
+void thread_pool_core::run(std::size_t worker_idx) noexcept {
+  worker *registered;
+  {
+    std::lock_guard<std::mutex> lock{workers_mutex_};
+    if (worker_idx < pool_workers_) {
+      registered = workers_[worker_idx].get();
+    } else {
+      registered = &register_worker();
+      active_workers_.fetch_add(1, std::memory_order_seq_cst);
+    }
+  }
+  worker &self = *registered;
+  worker *const prev_worker = std::exchange(current_, &self);
+  blocking_observer *const prev_observer =
+      std::exchange(current_blocking_observer(), &self);
+  if (options_.collect_stats)
+    self.last_finish = std::chrono::steady_clock::now();
+  bool woken = false;
+  while (!stopped_.load(std::memory_order_relaxed)) {
+    unique_function<void()> task;
+    // Worker woken up by notification starts searching right away so that
+    // posting threads don't wake up anybody else until it finds a task.
+    if ((!woken && find_task(self, task)) || search_task(self, task)) {
+      woken = false;
+      execute(self, task);
+      continue;
+    }
+    woken = false;
+
+    parked_.fetch_add(1, std::memory_order_seq_cst);
+    const auto key = self.parking.prepare_wait();
+    const bool closed = closed_.load(std::memory_order_acquire);
+    if (find_task(self, task)) {
+      cancel_park(self);
+      // Posting threads might have skipped notification relying on this
+      // worker which has just stopped searching.
+      wake_worker();
+      execute(self, task);
+      continue;
+    }
+    if (has_pending_tasks(self)) {
+      // Some task is being pushed right now or was taken by a competing thief
+      // while there are more of them left.
+      cancel_park(self);
+      std::this_thread::yield();
+      woken = true;
+      continue;
+    }
+    bool watching = false;
+    if (task_node *node = steal_lifo_slot(self, watching)) {
+      cancel_park(self);
+      task = std::move(node->func);
+      recycle(self, node);
+      execute(self, task);
+      continue;
+    }
+    if (closed) {
+      cancel_park(self);
+      break;
+    }
+    if (watching) {
+      // Registered after the slot check. Task put into a slot after it wakes
+      // this worker up via notification instead.
+      lifo_watchers_.fetch_add(1, std::memory_order_seq_cst);
+      self.parking.commit_wait_until(key, std::chrono::steady_clock::now() +
+                                              options_.lifo_slot_steal_delay);
+      lifo_watchers_.fetch_sub(1, std::memory_order_seq_cst);
+    } else {
+      self.parking.commit_wait(key);
+    }
+    parked_.fetch_sub(1, std::memory_order_relaxed);
+    woken = true;
+  }
+  current_blocking_observer() = prev_observer;
+  current_ = prev_worker;
+  // Tasks pushed while the workers were exiting are abandoned by the last one
+  // or by the posting thread. See abandon_if_closed.
+  if (active_workers_.fetch_sub(1, std::memory_order_seq_cst) == 1)
+    abandon_queued_tasks();
+}
+
+void thread_pool_core::close() {
+  closed_.store(true, std::memory_order_seq_cst);
+  queue_.close();
+  // Worker registered concurrently either is in the list loaded after the
+  // fence or sees the pool closed before parking.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  for (worker *w : *victims_.load(std::memory_order_acquire))
+    w->parking.notify_all();
+}
+
+void thread_pool_core::stop() {
+  stopped_.store(true, std::memory_order_relaxed);
+  close();
+  // Workers which have noticed stop before close could exit leaving the tasks
+  // pushed in between to the posting threads which haven't seen close yet.
+  if (active_workers_.load(std::memory_order_acquire) == 0)
+    abandon_queued_tasks();
+}
+
+bool thread_pool_core::has_node(unsigned node) const noexcept {
+  if (node >= node_queues_.size())
+    return false;
+  const auto &nodes = options_.worker_nodes;
+  if (nodes.empty())
+    return pool_workers_ != 0;
+  for (std::size_t i = 0; i < pool_workers_ && i < nodes.size(); ++i) {
+    if (nodes[i] == node)
+      return true;
+  }
+  return false;
+}
+
+bool thread_pool_core::has_worker(std::size_t worker) const noexcept {
+  return worker < pool_workers_;
+}
+
+thread_pool_stats thread_pool_core::stats() {
+  thread_pool_stats res;
+  res.queued_tasks = queue_.size() + ring_.size() + injected_.size() +
+                     high_tasks_.size() + low_tasks_.size();
+  for (const auto &queue : node_queues_)
+    res.queued_tasks += queue->size();
+
+  const auto collect = [](const worker::histogram &src,
+                          duration_histogram &dest) {
+    for (std::size_t i = 0; i < src.size(); ++i)
+      dest.buckets[i] += src[i].load(std::memory_order_relaxed);
+  };
+  std::lock_guard<std::mutex> lock{workers_mutex_};
+  res.workers.reserve(workers_.size());
+  for (const auto &w : workers_) {
+    res.queued_tasks += w->tasks.size() + w->targeted.size();
+    if (w->lifo_slot.load(std::memory_order_relaxed))
+      ++res.queued_tasks;
+
+    thread_pool_worker_stats item;
+    item.tasks_executed = w->started.load(std::memory_order_relaxed);
+    item.tasks_stolen = w->steals.load(std::memory_order_relaxed);
+    item.busy_time =
+        std::chrono::nanoseconds{w->busy_ns.load(std::memory_order_relaxed)};
+    item.idle_time =
+        std::chrono::nanoseconds{w->idle_ns.load(std::memory_order_relaxed)};
+    res.workers.push_back(item);
+    collect(w->queue_latency, res.queue_latency);
+    collect(w->execution_time, res.execution_time);
+  }
+  return res;
+}
+
+// Must be called with workers_mutex_ locked
+thread_pool_core::worker &thread_pool_core::register_worker() {
+  const std::size_t idx = workers_.size();
+  const auto &nodes = options_.worker_nodes;
+  const unsigned node = nodes.empty() ? 0u : nodes[idx % nodes.size()];
+  const auto seed = static_cast<std::uint32_t>(idx + 1) * UINT32_C(0x9E3779B9);
+  workers_.push_back(std::make_unique<worker>(this, idx, node, seed | 1));
+
+  auto victims = std::make_unique<std::vector<worker *>>();
+  victims->reserve(workers_.size());
+  for (const auto &w : workers_)
+    victims->push_back(w.get());
+  victims_.store(victims.get(), std::memory_order_release);
+  victim_lists_.push_back(std::move(victims));
+
+  return *workers_.back();
+}
+
+thread_pool_core::worker *thread_pool_core::current_worker() const noexcept {
+  worker *self = current_;
+  return self && self->owner == this ? self : nullptr;
+}
+
+injection_queue<thread_pool_core::task_node> &
+thread_pool_core::priority_queue(priority prio) noexcept {
+  return prio == priority::high ? high_tasks_ : low_tasks_;
+}
+
+bool thread_pool_core::find_task(worker &self, unique_function<void()> &task) {
+  if (options_.starvation_check_period != 0 &&
+      ++self.searches % options_.starvation_check_period == 0) {
+    if (take(self, low_tasks_.try_pop(), task) ||
+        find_regular_task(self, task))
+      return true;
+  }
+  return take(self, high_tasks_.try_pop(), task) ||
+         find_regular_task(self, task) ||
+         take(self, low_tasks_.try_pop(), task);
+}
+
+bool thread_pool_core::take(worker &self, task_node *node,
+                            unique_function<void()> &task) noexcept {
+  if (!node)
+    return false;
+  task = std::move(node->func);
+  recycle(self, node);
+  return true;
+}
+
+bool thread_pool_core::find_regular_task(worker &self,
+                                         unique_function<void()> &task) {
+  task_node *node = nullptr;
+  if (self.lifo_chain < options_.lifo_slot_budget)
+    node = self.lifo_slot.exchange(nullptr, std::memory_order_acquire);
+  if (node) {
+    ++self.lifo_chain;
+  } else if ((node = find_targeted_task(self))) {
+    self.lifo_chain = 0;
+  } else {
+    self.lifo_chain = 0;
+    switch (options_.scheduling) {
+    case thread_pool_scheduling::shared_queue:
+      if (queue_.try_pop(task))
+        return true;
+      break;
+    case thread_pool_scheduling::lock_free_queue:
+      if (ring_.try_pop(task))
+        return true;
+      break;
+    case thread_pool_scheduling::work_stealing:
+      node = find_queued_task(self);
+      break;
+    }
+    // Budget is exhausted but there is nothing else to do
+    if (!node)
+      node = self.lifo_slot.exchange(nullptr, std::memory_order_acquire);
+  }
+  return take(self, node, task);
+}
+
+bool thread_pool_core::search_task(worker &self,
+                                   unique_function<void()> &task) {
+  const unsigned attempts =
+      options_.idle_spin_count + options_.idle_yield_count;
+  if (attempts == 0)
+    return find_task(self, task);
+  searching_.fetch_add(1, std::memory_order_seq_cst);
+  for (unsigned i = 0; i < attempts; ++i) {
+    if (find_task(self, task)) {
+      // Posting threads skip notification while somebody searches. The last
+      // searcher to find a task wakes up a replacement so that tasks posted in
+      // a burst are not left for a single worker.
+      if (searching_.fetch_sub(1, std::memory_order_seq_cst) == 1)
+        wake_worker();
+      return true;
+    }
+    if (stopped_.load(std::memory_order_relaxed) ||
+        closed_.load(std::memory_order_relaxed))
+      break;
+    if (i < options_.idle_spin_count)
+      cpu_relax();
+    else
+      std::this_thread::yield();
+  }
+  // Decrement is ordered before the queues recheck done prior to parking so
+  // that either this worker finds the task posted concurrently or the posting
+  // thread sees no searchers and wakes up some parked worker.
+  searching_.fetch_sub(1, std::memory_order_seq_cst);
+  return false;
+}
+
+thread_pool_core::task_node *thread_pool_core::find_queued_task(worker &self) {
+  // Tasks posted from outside of the pool may starve while workers are busy
+  // with tasks they produce themselves. Check global queue first from time to
+  // time same way as Go scheduler does.
+  if (++self.tick % 61 == 0) {
+    if (task_node *node = injected_.try_pop())
+      return node;
+  }
+  if (task_node *node = self.tasks.pop())
+    return node;
+  if (task_node *node = injected_.try_pop())
+    return node;
+  return steal(self);
+}
+
+thread_pool_core::task_node *
+thread_pool_core::find_targeted_task(worker &self) {
+  if (task_node *node = self.targeted.try_pop())
+    return node;
+  return node_queues_[self.node]->try_pop();
+}
+
+thread_pool_core::task_node *thread_pool_core::steal(worker &self) {
+  const std::vector<worker *> *victims =
+      victims_.load(std::memory_order_acquire);
+  const std::size_t count = victims->size();
+  const std::size_t start = self.random() % count;
+  // Victims from the same NUMA node are tried first since their tasks likely
+  // use memory local to this node.
+  for (bool same_node : {true, false}) {
+    for (std::size_t i = 0; i < count; ++i) {
+      worker *victim = (*victims)[(start + i) % count];
+      if (victim == &self || (victim->node == self.node) != same_node)
+        continue;
+      if (task_node *node = victim->tasks.steal()) {
+        add<std::uint64_t>(self.steals, 1);
+        return node;
+      }
+    }
+  }
+  return nullptr;
+}
+
+// Takes the task from the LIFO slot of a blocked worker or of a worker which
+// has not started any other task since the slot was found occupied for the
+// steal delay. Sets `watching` if there is a slot to check again later.
+thread_pool_core::task_node *
+thread_pool_core::steal_lifo_slot(worker &self, bool &watching) {
+  const std::vector<worker *> *victims =
+      victims_.load(std::memory_order_acquire);
+  const worker *candidate = nullptr;
+  task_node *candidate_task = nullptr;
+  std::uint64_t candidate_started = 0;
+  bool watched_alive = false;
+  for (worker *victim : *victims) {
+    if (victim == &self)
+      continue;
+    task_node *node = victim->lifo_slot.load(std::memory_order_seq_cst);
+    if (!node)
+      continue;
+    if (!victim->blocked.load(std::memory_order_seq_cst)) {
+      // Owner picks up the task itself once the current one is finished.
+      // Owner blocking later wakes up an idle worker to get here again.
+      const std::uint64_t started =
+          victim->started.load(std::memory_order_relaxed);
+      if (victim != self.watched || node != self.watched_task ||
+          started != self.watched_started) {
+        if (!candidate) {
+          candidate = victim;
+          candidate_task = node;
+          candidate_started = started;
+        }
+        continue;
+      }
+      watched_alive = true;
+      if (std::chrono::steady_clock::now() - self.watched_since <
+          options_.lifo_slot_steal_delay)
+        continue;
+    }
+    if (victim->lifo_slot.compare_exchange_strong(node, nullptr,
+                                                  std::memory_order_acquire,
+                                                  std::memory_order_relaxed)) {
+      add<std::uint64_t>(self.steals, 1);
+      self.watched = nullptr;
+      return node;
+    }
+  }
+  if (!watched_alive) {
+    self.watched = candidate;
+    self.watched_task = candidate_task;
+    self.watched_started = candidate_started;
+    if (candidate)
+      self.watched_since = std::chrono::steady_clock::now();
+  }
+  watching = self.watched != nullptr;
+  return nullptr;
+}
+
+void thread_pool_core::execute(worker &self, unique_function<void()> &task) {
+  add<std::uint64_t>(self.started, 1);
+  if (options_.on_task_begin)
+    options_.on_task_begin(self.index);
+  if (options_.collect_stats) {
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    const auto idle = start - self.last_finish;
+    task();
+    self.last_finish = clock::now();
+    const auto busy = self.last_finish - start;
+    add<std::int64_t>(
+        self.idle_ns,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(idle).count());
+    add<std::int64_t>(
+        self.busy_ns,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(busy).count());
+    record(self.execution_time, busy);
+  } else {
+    task();
+  }
+  if (options_.on_task_end)
+    options_.on_task_end(self.index);
+}
+
+// Wraps the task so that it reports the time spent in the queue when started
+void thread_pool_core::stamp(unique_function<void()> &task) {
+  if (!options_.collect_stats)
+    return;
+  task = unique_function<void()>{
+      [this, posted = std::chrono::steady_clock::now(),
+       task = std::move(task)]() mutable {
+        if (worker *self = current_worker())
+          record(self->queue_latency,
+                 std::chrono::steady_clock::now() - posted);
+        task();
+      }};
+}
+
+void thread_pool_core::record(worker::histogram &histogram,
+                              std::chrono::nanoseconds duration) noexcept {
+  auto ns = static_cast<std::uint64_t>(std::max<std::int64_t>(
+      duration.count(), 0));
+  std::size_t bucket = 0;
+  while (ns > 1 && bucket + 1 < histogram.size()) {
+    ns >>= 1;
+    ++bucket;
+  }
+  add<std::uint64_t>(histogram[bucket], 1);
+}
+
+thread_pool_core::task_node *
+thread_pool_core::make_node(worker *self, unique_function<void()> &&task) {
+  task_node *node = self ? std::exchange(self->spare_node, nullptr) : nullptr;
+  if (!node)
+    node = free_nodes_.try_pop();
+  if (!node)
+    return new task_node{std::move(task)};
+  node->func = std::move(task);
+  return node;
+}
+
+void thread_pool_core::recycle(worker &self, task_node *node) noexcept {
+  node->next.store(nullptr, std::memory_order_relaxed);
+  if (!self.spare_node)
+    self.spare_node = node;
+  else if (free_nodes_.size() < max_free_nodes)
+    free_nodes_.push(node);
+  else
+    delete node;
+}
+
+// Check for closed_ done before the push races with close: the task pushed
+// after the workers have checked the queues for the last time would stay there
+// until the pool destruction. Either the posting thread sees no workers left
+// and abandons the task itself or the last worker exits after the push and
+// abandons it.
+void thread_pool_core::abandon_if_closed() noexcept {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (active_workers_.load(std::memory_order_acquire) == 0 &&
+      closed_.load(std::memory_order_acquire))
+    abandon_queued_tasks();
+}
+
+// Destroys all of the queued tasks. Must be called when no thread runs the
+// tasks. Destruction of a task may post other tasks (broken promise
+// notifications for example) and call this function recursively or
+// concurrently with another thread. Such calls only make the thread which is
+// already abandoning tasks to make one more pass over the queues.
+void thread_pool_core::abandon_queued_tasks() noexcept {
+  if (abandon_requests_.fetch_add(1, std::memory_order_acq_rel) != 0)
+    return;
+  const auto abandon_all = [](injection_queue<task_node> &queue) {
+    // Size includes nodes being pushed right now which are not reachable yet
+    while (queue.size() != 0) {
+      if (task_node *node = queue.try_pop())
+        delete node;
+      else
+        std::this_thread::yield();
+    }
+  };
+  unsigned served;
+  do {
+    served = abandon_requests_.load(std::memory_order_acquire);
+    for (;;) {
+      unique_function<void()> task;
+      if (!queue_.try_pop(task) && !ring_.try_pop(task))
+        break;
+    }
+    std::lock_guard<std::mutex> lock{workers_mutex_};
+    for (auto &w : workers_) {
+      delete w->lifo_slot.exchange(nullptr, std::memory_order_acquire);
+      while (task_node *node = w->tasks.pop())
+        delete node;
+      abandon_all(w->targeted);
+    }
+    for (auto &queue : node_queues_)
+      abandon_all(*queue);
+    for (auto *queue : {&injected_, &high_tasks_, &low_tasks_})
+      abandon_all(*queue);
+  } while (abandon_requests_.fetch_sub(served, std::memory_order_acq_rel) !=
+           served);
+}
+
+bool thread_pool_core::has_pending_tasks(const worker &self) const noexcept {
+  if (self.targeted.size() != 0 || node_queues_[self.node]->size() != 0 ||
+      high_tasks_.size() != 0 || low_tasks_.size() != 0)
+    return true;
+  if (options_.scheduling != thread_pool_scheduling::work_stealing)
+    return false;
+  if (injected_.size() != 0)
+    return true;
+  const std::vector<worker *> *victims =
+      victims_.load(std::memory_order_acquire);
+  for (const worker *victim : *victims) {
+    if (!victim->tasks.empty())
+      return true;
+  }
+  return false;
+}
+
+void thread_pool_core::cancel_park(worker &self) noexcept {
+  self.parking.cancel_wait();
+  parked_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// Wakes up one of the parked workers satisfying the predicate. Pairs with the
+// parked_ increment in run: either the parking worker finds the task already
+// pushed or this thread sees it parking.
+template <typename P>
+bool thread_pool_core::wake_parked(P &&eligible) noexcept {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (parked_.load(std::memory_order_relaxed) == 0)
+    return false;
+  for (worker *w : *victims_.load(std::memory_order_acquire)) {
+    if (eligible(*w) && w->parking.notify_one())
+      return true;
+  }
+  return false;
+}
+
+void thread_pool_core::wake_worker() noexcept {
+  // Pairs with the searching_ decrement in search_task: either the searcher
+  // finds the task already pushed or this thread sees that nobody searches.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (searching_.load(std::memory_order_relaxed) != 0)
+    return;
+  wake_parked([](const worker &) { return true; });
+}
+
+void thread_pool_core::wake_workers(std::size_t count) noexcept {
+  // Searching workers are going to pick up some of the tasks and wake up
+  // replacements themselves.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const unsigned searching = searching_.load(std::memory_order_relaxed);
+  if (searching >= count)
+    return;
+  count -= searching;
+  if (parked_.load(std::memory_order_relaxed) == 0)
+    return;
+  for (worker *w : *victims_.load(std::memory_order_acquire)) {
+    if (count == 0)
+      break;
+    if (w->parking.notify_one())
+      --count;
+  }
+}
+
+void post(thread_pool_core &core, priority prio,
+          unique_function<void()> &&task) {
+  core.post(prio, std::move(task));
+}
+
+void post_bulk(thread_pool_core &core, priority prio,
+               unique_function<void()> *tasks, std::size_t count) {
+  core.post_bulk(prio, tasks, count);
+}
+
+void post_to_node(thread_pool_core &core, unsigned node,
+                  unique_function<void()> &&task) {
+  core.post_to_node(node, std::move(task));
+}
+
+void post_to_worker(thread_pool_core &core, std::size_t worker,
+                    unique_function<void()> &&task) {
+  core.post_to_worker(worker, std::move(task));
+}
+
+namespace {
+
+#if defined(__linux__)
+// Parses CPU list in the kernel format: "0-3,8,10-11"
+std::vector<unsigned> parse_cpu_list(const std::string &list) {
+  std::vector<unsigned> res;
+  std::istringstream in{list};
+  std::string range;
+  while (std::getline(in, range, ',')) {
+    unsigned first = 0, last = 0;
+    const int parsed = std::sscanf(range.c_str(), "%u-%u", &first, &last);
+    if (parsed < 1)
+      continue;
+    if (parsed == 1)
+      last = first;
+    for (unsigned cpu = first; cpu <= last; ++cpu)
+      res.push_back(cpu);
+  }
+  return res;
+}
+#endif
+
+void pin_thread(std::thread &thread, const std::vector<unsigned> &cpus) {
+#if defined(__linux__)
+  if (cpus.empty())
+    return;
+  const unsigned max_cpu = *std::max_element(cpus.begin(), cpus.end());
+  cpu_set_t *set = CPU_ALLOC(max_cpu + 1);
+  if (!set)
+    throw std::bad_alloc{};
+  const std::size_t set_size = CPU_ALLOC_SIZE(max_cpu + 1);
+  CPU_ZERO_S(set_size, set);
+  for (unsigned cpu : cpus)
+    CPU_SET_S(cpu, set_size, set);
+  const int err =
+      ::pthread_setaffinity_np(thread.native_handle(), set_size, set);
+  CPU_FREE(set);
+  if (err != 0)
+    throw std::system_error{err, std::system_category(),
+                            "Failed to set worker thread CPU affinity"};
+#else
+  (void)thread;
+  (void)cpus;
+#endif
+}
+
+} // namespace
+
+} // namespace detail
+
+thread_pool_options numa_thread_pool_options(thread_pool_options options) {
+#if defined(__linux__)
+  std::vector<unsigned> nodes;
+  std::vector<std::vector<unsigned>> cpus;
+  for (unsigned node = 0;; ++node) {
+    std::ifstream cpulist{"/sys/devices/system/node/node" +
+                          std::to_string(node) + "/cpulist"};
+    if (!cpulist)
+      break;
+    std::string list;
+    std::getline(cpulist, list);
+    auto node_cpus = detail::parse_cpu_list(list);
+    // Memory only nodes have no CPUs
+    if (node_cpus.empty())
+      continue;
+    nodes.push_back(node);
+    cpus.push_back(std::move(node_cpus));
+  }
+  if (nodes.empty())
+    return options;
+  options.worker_nodes = std::move(nodes);
+  options.worker_cpus = std::move(cpus);
+#endif
+  return options;
+}
+
+static_thread_pool::static_thread_pool(std::size_t num_threads)
+    : static_thread_pool(num_threads, thread_pool_options{}) {}
+
+static_thread_pool::static_thread_pool(std::size_t num_threads,
+                                       const thread_pool_options &options)
+    : core_{std::make_unique<detail::thread_pool_core>(options, num_threads)} {
+  threads_.reserve(num_threads);
+  for (std::size_t i = 0; i < num_threads; ++i)
+    threads_.push_back(std::thread{&static_thread_pool::serve, this, i});
+  if (options.worker_cpus.empty())
+    return;
+  try {
+    for (std::size_t i = 0; i < num_threads; ++i)
+      detail::pin_thread(threads_[i],
+                         options.worker_cpus[i % options.worker_cpus.size()]);
+  } catch (...) {
+    stop();
+    wait();
+    throw;
+  }
+}
+
+static_thread_pool::~static_thread_pool() {
+  stop();
+  wait();
+}
+
+void static_thread_pool::attach() {
+  serve(std::numeric_limits<std::size_t>::max());
+}
+
+void static_thread_pool::serve(std::size_t worker) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    ++attached_threads_;
+  }
+  core_->run(worker);
+  {
+    std::unique_lock<std::mutex> lock{mutex_};
+    --attached_threads_;
+    cv_.wait(lock, [&] { return attached_threads_ == 0; });
+  }
+  cv_.notify_all();
+}
+
+void static_thread_pool::stop() { core_->stop(); }
+
+static_thread_pool::targeted_executor_type
+static_thread_pool::node_executor(unsigned node) {
+  if (!core_->has_node(node))
+    throw std::out_of_range{"static_thread_pool has no workers on the node"};
+  return {core_.get(), targeted_executor_type::target::node, node};
+}
+
+thread_pool_stats static_thread_pool::stats() const { return core_->stats(); }
+
+static_thread_pool::targeted_executor_type
+static_thread_pool::worker_executor(std::size_t worker) {
+  if (!core_->has_worker(worker))
+    throw std::out_of_range{"static_thread_pool has no such worker"};
+  return {core_.get(), targeted_executor_type::target::worker, worker};
+}
+
+void static_thread_pool::wait() {
+  core_->close();
+  for (auto &thread : threads_) {
+    if (thread.joinable())
+      thread.join();
+  }
+  threads_.clear();
+}
+
+} // namespace cxx14_v1
+} // namespace portable_concurrency
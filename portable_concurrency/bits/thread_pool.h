@@ -1,32 +1,290 @@
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <type_traits>
+#include <vector>
 
-#include "closable_queue.h"
 #include "execution.h"
 #include "unique_function.hpp"
 
 namespace portable_concurrency {
 inline namespace cxx14_v1 {
 
+/**
+ * @headerfile portable_concurrency/thread_pool
+ * @ingroup thread_pool
+ * @brief Strategy used by @ref static_thread_pool to distribute tasks between
+ * worker threads.
+ */
+enum class thread_pool_scheduling {
+  /// All tasks are stored in a single FIFO queue protected by a mutex.
+  shared_queue,
+  /**
+   * Every worker owns a Chase-Lev deque. Tasks posted from a worker thread are
+   * pushed to the deque of this worker, tasks posted from any other thread are
+   * pushed to a lock-free injection queue. Idle workers steal tasks from
+   * randomly selected victims.
+   */
+  work_stealing,
+  /**
+   * All tasks are stored in a single lock-free FIFO ring buffer. Tasks which
+   * don't fit into the ring are moved to the mutex protected overflow list.
+   */
+  lock_free_queue
+};
+
+/**
+ * @headerfile portable_concurrency/thread_pool
+ * @ingroup thread_pool
+ * @brief Priority of the tasks posted to the @ref static_thread_pool.
+ *
+ * Idle workers pick up tasks of higher priority first. Lower priority tasks
+ * are not starved completely: see
+ * @ref thread_pool_options::starvation_check_period.
+ */
+enum class priority { low, normal, high };
+
+/**
+ * @headerfile portable_concurrency/thread_pool
+ * @ingroup thread_pool
+ * @brief Tuning parameters of the @ref static_thread_pool.
+ */
+struct thread_pool_options {
+  thread_pool_scheduling scheduling = thread_pool_scheduling::shared_queue;
+
+  /**
+   * Maximum number of tasks executed in a row from the worker LIFO slot.
+   *
+   * Task posted to the pool from one of its worker threads is placed into the
+   * LIFO slot of this worker and executed right after the current task while
+   * the data it uses is still hot in the CPU cache. Task which previously
+   * occupied the slot is moved to the regular queue. Once the budget is
+   * exhausted the worker takes a task from the regular queue so long chains of
+   * continuations can't starve other tasks. Idle workers take the task from
+   * the LIFO slot of a busy worker if this worker is blocked waiting for a
+   * future or a latch or if it hasn't started any other task for
+   * @ref lifo_slot_steal_delay.
+   *
+   * Zero value disables LIFO slot so that the tasks posted from the worker
+   * threads are executed in the order of the regular queue.
+   */
+  unsigned lifo_slot_budget = 16;
+
+  /**
+   * Time the task stays in the LIFO slot of a busy worker before idle workers
+   * are allowed to take it.
+   */
+  std::chrono::nanoseconds lifo_slot_steal_delay =
+      std::chrono::microseconds{50};
+
+  /**
+   * Number of attempts to find a task made by an idle worker with CPU pause
+   * hint between them before it starts to yield its time slice.
+   *
+   * Worker searching for a task picks up the next posted one without the
+   * wakeup latency of the parked thread. While at least one worker searches
+   * for a task posting threads do not wake up parked workers.
+   */
+  unsigned idle_spin_count = 64;
+
+  /**
+   * Number of attempts to find a task made by an idle worker with
+   * `std::this_thread::yield` calls between them after spinning and before
+   * parking.
+   */
+  unsigned idle_yield_count = 4;
+
+  /**
+   * Every `starvation_check_period`-th search for a task made by a worker
+   * checks the queues from the lowest priority to the highest one. This way
+   * low priority tasks make progress even if high priority tasks are posted
+   * all the time.
+   *
+   * Zero value makes priorities strict.
+   */
+  unsigned starvation_check_period = 31;
+
+  /**
+   * CPU sets to pin the worker threads to. Worker thread with index `i` is
+   * pinned to the CPUs listed in `worker_cpus[i % worker_cpus.size()]`. Empty
+   * vector disables pinning.
+   *
+   * Pinning is only supported on Linux and ignored on other platforms. Threads
+   * attached to the pool with @ref static_thread_pool::attach are never pinned.
+   */
+  std::vector<std::vector<unsigned>> worker_cpus;
+
+  /**
+   * NUMA node of each worker. Worker with index `i` belongs to the node
+   * `worker_nodes[i % worker_nodes.size()]`. Empty vector puts all of the
+   * workers to the node 0.
+   *
+   * Each node has its own queue for the tasks posted via
+   * @ref static_thread_pool::node_executor. Workers stealing tasks prefer
+   * victims from their own node.
+   */
+  std::vector<unsigned> worker_nodes;
+
+  /**
+   * Measure task latencies as well as busy and idle time of the workers. Each
+   * posted task is wrapped into a function which remembers the time it was
+   * posted at and each executed task is timed. Measurements are available via
+   * @ref static_thread_pool::stats.
+   */
+  bool collect_stats = false;
+
+  /**
+   * Functions called on the worker thread right before and right after
+   * execution of each task with the index of this worker. Indexes of the
+   * threads created by the pool are `[0, num_threads)`, threads attached with
+   * @ref static_thread_pool::attach get subsequent indexes. If a hook exits
+   * via exception `std::terminate` is called.
+   */
+  std::function<void(std::size_t worker)> on_task_begin;
+  std::function<void(std::size_t worker)> on_task_end;
+};
+
+/**
+ * @headerfile portable_concurrency/thread_pool
+ * @ingroup thread_pool
+ * @brief Histogram of durations with logarithmic buckets.
+ *
+ * Bucket `0` counts durations shorter than 2ns, bucket `i` counts durations in
+ * the range `[2^i, 2^(i+1))` nanoseconds. The last bucket also counts all of
+ * the longer durations.
+ */
+struct duration_histogram {
+  std::array<std::uint64_t, 40> buckets{};
+
+  /// Total number of measurements
+  std::uint64_t count() const noexcept {
+    std::uint64_t res = 0;
+    for (std::uint64_t bucket : buckets)
+      res += bucket;
+    return res;
+  }
+};
+
+/**
+ * @headerfile portable_concurrency/thread_pool
+ * @ingroup thread_pool
+ * @brief Counters of a single @ref static_thread_pool worker.
+ */
+struct thread_pool_worker_stats {
+  /// Number of tasks started by this worker
+  std::uint64_t tasks_executed = 0;
+  /// Number of tasks taken from the other workers
+  std::uint64_t tasks_stolen = 0;
+  /// Time spent executing tasks. Only measured with `collect_stats` option.
+  std::chrono::nanoseconds busy_time{0};
+  /// Time spent between tasks. Only measured with `collect_stats` option.
+  std::chrono::nanoseconds idle_time{0};
+};
+
+/**
+ * @headerfile portable_concurrency/thread_pool
+ * @ingroup thread_pool
+ * @brief Snapshot of the @ref static_thread_pool counters.
+ *
+ * Counters are collected by each worker separately without synchronization so
+ * the snapshot is not atomic: values read for different workers may
+ * correspond to slightly different moments.
+ */
+struct thread_pool_stats {
+  /// Approximate number of tasks waiting for execution
+  std::size_t queued_tasks = 0;
+  std::vector<thread_pool_worker_stats> workers;
+  /// Time between task posting and the start of its execution
+  duration_histogram queue_latency;
+  /// Time of the task execution
+  duration_histogram execution_time;
+};
+
+/**
+ * @headerfile portable_concurrency/thread_pool
+ * @ingroup thread_pool
+ * @brief Returns a copy of the `options` with the workers distributed evenly
+ * among the NUMA nodes of the current machine and pinned to the CPUs of their
+ * nodes.
+ *
+ * NUMA topology is read from `/sys/devices/system/node` on Linux. Options are
+ * returned unmodified if the topology is unavailable.
+ */
+thread_pool_options numa_thread_pool_options(thread_pool_options options = {});
+
 namespace detail {
-extern template class closable_queue<unique_function<void()>>;
+
+class thread_pool_core;
+
+void post(thread_pool_core &core, priority prio,
+          unique_function<void()> &&task);
+void post_bulk(thread_pool_core &core, priority prio,
+               unique_function<void()> *tasks, std::size_t count);
 
 class queue_executor {
 public:
-  queue_executor(closable_queue<unique_function<void()>> *queue) noexcept
-      : queue_{queue} {}
+  queue_executor(thread_pool_core *core,
+                 priority prio = priority::normal) noexcept
+      : core_{core}, prio_{prio} {}
 
 private:
   friend void post(queue_executor exec, unique_function<void()> fun) {
-    exec.queue_->push(std::move(fun));
+    post(*exec.core_, exec.prio_, std::move(fun));
+  }
+
+  friend void post_bulk(queue_executor exec, unique_function<void()> *first,
+                        unique_function<void()> *last) {
+    post_bulk(*exec.core_, exec.prio_, first,
+              static_cast<std::size_t>(last - first));
+  }
+
+  template <typename InputIt>
+  friend void post_bulk(queue_executor exec, InputIt first, InputIt last) {
+    std::vector<unique_function<void()>> tasks;
+    for (; first != last; ++first)
+      tasks.emplace_back(std::move(*first));
+    post_bulk(*exec.core_, exec.prio_, tasks.data(), tasks.size());
   }
 
 private:
-  closable_queue<unique_function<void()>> *queue_;
+  thread_pool_core *core_;
+  priority prio_;
+};
+
+void post_to_node(thread_pool_core &core, unsigned node,
+                  unique_function<void()> &&task);
+void post_to_worker(thread_pool_core &core, std::size_t worker,
+                    unique_function<void()> &&task);
+
+class targeted_executor {
+public:
+  enum class target { node, worker };
+
+  targeted_executor(thread_pool_core *core, target kind,
+                    std::size_t idx) noexcept
+      : core_{core}, idx_{idx}, kind_{kind} {}
+
+private:
+  friend void post(targeted_executor exec, unique_function<void()> fun) {
+    if (exec.kind_ == target::node)
+      post_to_node(*exec.core_, static_cast<unsigned>(exec.idx_),
+                   std::move(fun));
+    else
+      post_to_worker(*exec.core_, exec.idx_, std::move(fun));
+  }
+
+private:
+  thread_pool_core *core_;
+  std::size_t idx_;
+  target kind_;
 };
 
 } // namespace detail
@@ -38,8 +296,11 @@ private:
 class static_thread_pool {
 public:
   using executor_type = detail::queue_executor;
+  using targeted_executor_type = detail::targeted_executor;
 
   explicit static_thread_pool(std::size_t num_threads);
+  static_thread_pool(std::size_t num_threads,
+                     const thread_pool_options &options);
 
   static_thread_pool(const static_thread_pool &) = delete;
   static_thread_pool &operator=(const static_thread_pool &) = delete;
@@ -56,15 +317,40 @@ public:
   /// wait for all threads in the thread pool to complete
   void wait();
 
-  executor_type executor() noexcept { return {&queue_}; }
+  executor_type executor() noexcept { return {core_.get()}; }
+
+  /// Returns executor which posts tasks with the priority specified
+  executor_type executor(priority prio) noexcept { return {core_.get(), prio}; }
+
+  /**
+   * Returns executor which runs tasks only on the worker threads belonging to
+   * the NUMA node `node`.
+   *
+   * @throws std::out_of_range if there are no worker threads on this node
+   */
+  targeted_executor_type node_executor(unsigned node);
+
+  /**
+   * Returns executor which runs tasks only on the worker thread with index
+   * `worker` created by this pool.
+   *
+   * @throws std::out_of_range if `worker` is not less than the number of
+   * threads created by this pool
+   */
+  targeted_executor_type worker_executor(std::size_t worker);
+
+  /// Returns snapshot of the pool counters
+  thread_pool_stats stats() const;
 
 private:
-  detail::closable_queue<unique_function<void()>> queue_;
+  void serve(std::size_t worker);
+
+private:
+  std::unique_ptr<detail::thread_pool_core> core_;
   std::vector<std::thread> threads_;
   unsigned attached_threads_ = 0;
   std::mutex mutex_;
   std::condition_variable cv_;
-  std::atomic<bool> stopped_{false};
 };
 
 } // namespace cxx14_v1
@@ -73,4 +359,8 @@ template <>
 struct is_executor<cxx14_v1::static_thread_pool::executor_type>
     : std::true_type {};
 
+template <>
+struct is_executor<cxx14_v1::static_thread_pool::targeted_executor_type>
+    : std::true_type {};
+
 } // namespace portable_concurrency
@@ -1,12 +1,11 @@
 #pragma once
 
 #include <chrono>
-#include <condition_variable>
-#include <memory>
-#include <mutex>
 
 #include "future.h"
+#include "future_state.h"
 #include "shared_future.h"
+#include "state_ptr.h"
 
 namespace portable_concurrency {
 inline namespace cxx14_v1 {
@@ -21,13 +20,6 @@ inline namespace cxx14_v1 {
  * optimizations.
  */
 class timed_waiter {
-private:
-  struct waiter {
-    std::mutex mutex;
-    std::condition_variable cv;
-    bool notified = false;
-  };
-
 public:
   /**
    * @brief Constructs `timed_waiter` in some unspecified state.
@@ -39,31 +31,26 @@ public:
 
   /**
    * @brief Constructs `timed_waiter` associated with @a fut object.
+   *
+   * Neither construction nor waiting allocate memory. Waiter doesn't prolong
+   * the lifetime of the result of the operation but keeps the memory of its
+   * shared state allocated until the waiter is destroyed. If the future is
+   * destroyed before the result is set waiting ends with timeout.
    */
   template <typename T>
-  explicit timed_waiter(future<T> &fut) : waiter_{std::make_shared<waiter>()} {
-    fut.notify([waiter = waiter_] {
-      {
-        std::lock_guard<std::mutex> lock{waiter->mutex};
-        waiter->notified = true;
-      }
-      waiter->cv.notify_all();
-    });
-  }
+  explicit timed_waiter(future<T> &fut)
+      : state_{detail::existing_state_of(fut)} {}
   /**
    * @brief Constructs `timed_waiter` associated with @a fut object.
+   *
+   * Neither construction nor waiting allocate memory. Waiter doesn't prolong
+   * the lifetime of the result of the operation but keeps the memory of its
+   * shared state allocated until the waiter is destroyed. If the future is
+   * destroyed before the result is set waiting ends with timeout.
    */
   template <typename T>
   explicit timed_waiter(shared_future<T> &fut)
-      : waiter_{std::make_shared<waiter>()} {
-    fut.notify([waiter = waiter_] {
-      {
-        std::lock_guard<std::mutex> lock{waiter->mutex};
-        waiter->notified = true;
-      }
-      waiter->cv.notify_all();
-    });
-  }
+      : state_{detail::state_of(fut)} {}
 
   /**
    * @brief Waits for the result, returns if it is not available for the
@@ -71,10 +58,7 @@ public:
    */
   template <typename Rep, typename Per>
   future_status wait_for(const std::chrono::duration<Rep, Per> &dur) {
-    std::unique_lock<std::mutex> lk{waiter_->mutex};
-    return waiter_->cv.wait_for(lk, dur, [&] { return waiter_->notified; })
-               ? future_status::ready
-               : future_status::timeout;
+    return wait_until(std::chrono::steady_clock::now() + dur);
   }
 
   /**
@@ -83,14 +67,25 @@ public:
    */
   template <typename Clock, typename Dur>
   future_status wait_until(const std::chrono::time_point<Clock, Dur> &tp) {
-    std::unique_lock<std::mutex> lk{waiter_->mutex};
-    return waiter_->cv.wait_until(lk, tp, [&] { return waiter_->notified; })
-               ? future_status::ready
-               : future_status::timeout;
+    // Future created ready with the value stored inline has no shared state
+    if (!state_.get())
+      return future_status::ready;
+    // State might be already disposed if the future is destroyed but the
+    // continuations stack stays alive while there is a weak reference. Stack
+    // of the disposed state is discarded and never becomes ready.
+    auto &continuations = state_.get()->continuations();
+    for (auto now = Clock::now(); now < tp && !continuations.is_ready();
+         now = Clock::now()) {
+      if (continuations.wait_for(
+              std::chrono::duration_cast<std::chrono::nanoseconds>(tp - now)))
+        return future_status::ready;
+    }
+    return continuations.is_ready() ? future_status::ready
+                                    : future_status::timeout;
   }
 
 private:
-  std::shared_ptr<waiter> waiter_;
+  detail::weak_state_ptr<detail::future_state_base> state_;
 };
 
 } // namespace cxx14_v1
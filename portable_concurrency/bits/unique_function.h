@@ -8,31 +8,37 @@
 namespace portable_concurrency {
 inline namespace cxx14_v1 {
 
+template <typename S, std::size_t Size = detail::small_buffer_size,
+          std::size_t Align = detail::small_buffer_align>
+class basic_unique_function;
+
 template <typename S> class unique_function;
 
 /**
  * @headerfile portable_concurrency/functional
  * @ingroup functional
- * @brief Move-only type erasure for arbitrary callable object.
+ * @brief Move-only type erasure for arbitrary callable object with the small
+ * object optimization buffer of configurable size.
  *
- * Implementation of
- * http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2015/n4543.pdf proposal.
- *
- * @a portable_concurrency/functional_fwd header provides lightweight forward
- * declarations of this class template public interface allowing to use this
- * class as parameter or return type of function declarations or as member of
- * classes.
+ * Callable objects with size up to `Size` bytes and alignment up to `Align`
+ * which are nothrow move constructible are stored in the internal buffer
+ * without heap allocation. Bigger objects are allocated on heap. Interface is
+ * the same as the one of @ref unique_function.
  */
-template <typename R, typename... A> class unique_function<R(A...)> {
+template <typename R, typename... A, std::size_t Size, std::size_t Align>
+class basic_unique_function<R(A...), Size, Align> {
+  static_assert(Size >= sizeof(void *) && Align >= alignof(void *),
+                "Small buffer must be able to store a pointer");
+
 public:
   /**
    * Creates empty `unique_function` object
    */
-  unique_function() noexcept;
+  basic_unique_function() noexcept;
   /**
    * Creates empty `unique_function` object
    */
-  unique_function(std::nullptr_t) noexcept;
+  basic_unique_function(std::nullptr_t) noexcept;
 
   /**
    * Creates `unique_function` holding a function @a f.
@@ -52,36 +58,37 @@ public:
    * any function type which is sent to a user provided executor via
    * ADL-discovered function `post`.
    */
-  template <typename F, typename = std::enable_if_t<!std::is_same<
-                            std::decay_t<F>, unique_function>::value>>
-  unique_function(F &&f);
+  template <typename F, typename = std::enable_if_t<!std::is_base_of<
+                            basic_unique_function, std::decay_t<F>>::value>>
+  basic_unique_function(F &&f);
 
   /**
    * Destroys any stored function object.
    */
-  ~unique_function();
+  ~basic_unique_function();
 
   /**
    * Move @a rhs into newly created object.
    */
-  unique_function(unique_function &&) noexcept;
+  basic_unique_function(basic_unique_function &&) noexcept;
 
   /// Unique function is not CopyConstructible
-  unique_function(const unique_function &) = delete;
+  basic_unique_function(const basic_unique_function &) = delete;
   /// Unique function is not CopyAssignable
-  unique_function &operator=(const unique_function &) = delete;
+  basic_unique_function &operator=(const basic_unique_function &) = delete;
 
   /**
    * Destroy function object stored in this `unique_function` object (if any)
    * and move function object from `rhs` to `*this`.
    */
-  unique_function &operator=(unique_function &&rhs) noexcept;
+  basic_unique_function &operator=(basic_unique_function &&rhs) noexcept;
 
-  unique_function(detail::small_unique_function<R(A...)> &&rhs) noexcept;
-  unique_function &
-  operator=(detail::small_unique_function<R(A...)> &&rhs) noexcept;
+  basic_unique_function(
+      detail::small_unique_function<R(A...), Size, Align> &&rhs) noexcept;
+  basic_unique_function &
+  operator=(detail::small_unique_function<R(A...), Size, Align> &&rhs) noexcept;
 
-  operator detail::small_unique_function<R(A...)> &&() &&noexcept;
+  operator detail::small_unique_function<R(A...), Size, Align> &&() &&noexcept;
 
   /**
    * Calls stored function object with parameters @a args and returns result of
@@ -102,15 +109,42 @@ public:
   }
 
 private:
-  template <typename F> unique_function(F &&f, std::true_type);
+  template <typename F> basic_unique_function(F &&f, std::true_type);
 
-  template <typename F> unique_function(F &&f, std::false_type);
+  template <typename F> basic_unique_function(F &&f, std::false_type);
 
 private:
-  detail::small_unique_function<R(A...)> func_;
+  detail::small_unique_function<R(A...), Size, Align> func_;
+};
+
+/**
+ * @headerfile portable_concurrency/functional
+ * @ingroup functional
+ * @brief Move-only type erasure for arbitrary callable object.
+ *
+ * Implementation of
+ * http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2015/n4543.pdf proposal.
+ *
+ * Uses the small object optimization buffer of the default size which is
+ * `5 * sizeof(void *)` bytes and can be enlarged for the whole library build
+ * by the `PC_SMALL_BUFFER_SIZE` CMake option. The same buffer size is used by
+ * the continuations attached to futures and the tasks posted to the thread
+ * pools. Use @ref basic_unique_function to select the buffer size per object.
+ *
+ * @a portable_concurrency/functional_fwd header provides lightweight forward
+ * declarations of this class template public interface allowing to use this
+ * class as parameter or return type of function declarations or as member of
+ * classes.
+ */
+template <typename R, typename... A>
+class unique_function<R(A...)> : public basic_unique_function<R(A...)> {
+public:
+  using basic_unique_function<R(A...)>::basic_unique_function;
+
+  unique_function() noexcept = default;
 };
 
-extern template class unique_function<void()>;
+extern template class basic_unique_function<void()>;
 
 } // namespace cxx14_v1
 } // namespace portable_concurrency
@@ -4,69 +4,78 @@
 #include <type_traits>
 
 #include "invoke.h"
+#include "memory_pool.h"
 #include "small_unique_function.hpp"
 #include "unique_function.h"
 
 namespace portable_concurrency {
 inline namespace cxx14_v1 {
 
-template <typename R, typename... A>
-unique_function<R(A...)>::unique_function() noexcept = default;
+template <typename R, typename... A, std::size_t Size, std::size_t Align>
+basic_unique_function<R(A...), Size, Align>::basic_unique_function() noexcept =
+    default;
 
-template <typename R, typename... A>
-unique_function<R(A...)>::unique_function(std::nullptr_t) noexcept {}
+template <typename R, typename... A, std::size_t Size, std::size_t Align>
+basic_unique_function<R(A...), Size, Align>::basic_unique_function(
+    std::nullptr_t) noexcept {}
 
-template <typename R, typename... A>
+template <typename R, typename... A, std::size_t Size, std::size_t Align>
 template <typename F, typename>
-unique_function<R(A...)>::unique_function(F &&f)
-    : unique_function(std::forward<F>(f),
-                      detail::is_storable_t<std::decay_t<F>>{}) {}
+basic_unique_function<R(A...), Size, Align>::basic_unique_function(F &&f)
+    : basic_unique_function(
+          std::forward<F>(f),
+          detail::is_storable_t<std::decay_t<F>, Size, Align>{}) {}
 
-template <typename R, typename... A>
+template <typename R, typename... A, std::size_t Size, std::size_t Align>
 template <typename F>
-unique_function<R(A...)>::unique_function(F &&f, std::true_type)
+basic_unique_function<R(A...), Size, Align>::basic_unique_function(
+    F &&f, std::true_type)
     : func_(std::forward<F>(f)) {}
 
-template <typename R, typename... A>
+template <typename R, typename... A, std::size_t Size, std::size_t Align>
 template <typename F>
-unique_function<R(A...)>::unique_function(F &&f, std::false_type) {
+basic_unique_function<R(A...), Size, Align>::basic_unique_function(
+    F &&f, std::false_type) {
   if (detail::is_null(f))
     return;
-  func_ = [func = std::make_unique<std::decay_t<F>>(std::forward<F>(f))](
+  func_ = [func = detail::make_pooled<std::decay_t<F>>(std::forward<F>(f))](
               A... a) { return detail::invoke(*func, std::forward<A>(a)...); };
 }
 
-template <typename R, typename... A>
-unique_function<R(A...)>::~unique_function() = default;
+template <typename R, typename... A, std::size_t Size, std::size_t Align>
+basic_unique_function<R(A...), Size, Align>::~basic_unique_function() =
+    default;
 
-template <typename R, typename... A>
-unique_function<R(A...)>::unique_function(
-    unique_function<R(A...)> &&) noexcept = default;
+template <typename R, typename... A, std::size_t Size, std::size_t Align>
+basic_unique_function<R(A...), Size, Align>::basic_unique_function(
+    basic_unique_function &&) noexcept = default;
 
-template <typename R, typename... A>
-unique_function<R(A...)> &unique_function<R(A...)>::operator=(
-    unique_function<R(A...)> &&) noexcept = default;
+template <typename R, typename... A, std::size_t Size, std::size_t Align>
+basic_unique_function<R(A...), Size, Align> &
+basic_unique_function<R(A...), Size, Align>::operator=(
+    basic_unique_function &&) noexcept = default;
 
-template <typename R, typename... A>
-R unique_function<R(A...)>::operator()(A... args) const {
+template <typename R, typename... A, std::size_t Size, std::size_t Align>
+R basic_unique_function<R(A...), Size, Align>::operator()(A... args) const {
   return func_(std::forward<A>(args)...);
 }
 
-template <typename R, typename... A>
-unique_function<R(A...)>::unique_function(
-    detail::small_unique_function<R(A...)> &&rhs) noexcept
+template <typename R, typename... A, std::size_t Size, std::size_t Align>
+basic_unique_function<R(A...), Size, Align>::basic_unique_function(
+    detail::small_unique_function<R(A...), Size, Align> &&rhs) noexcept
     : func_(std::move(rhs)) {}
 
-template <typename R, typename... A>
-unique_function<R(A...)> &unique_function<R(A...)>::operator=(
-    detail::small_unique_function<R(A...)> &&rhs) noexcept {
+template <typename R, typename... A, std::size_t Size, std::size_t Align>
+basic_unique_function<R(A...), Size, Align> &
+basic_unique_function<R(A...), Size, Align>::operator=(
+    detail::small_unique_function<R(A...), Size, Align> &&rhs) noexcept {
   func_ = std::move(rhs);
   return *this;
 }
 
-template <typename R, typename... A>
-unique_function<R(A...)>::operator detail::small_unique_function<R(A...)> &&()
-    &&noexcept {
+template <typename R, typename... A, std::size_t Size, std::size_t Align>
+basic_unique_function<R(A...), Size, Align>::
+operator detail::small_unique_function<R(A...), Size, Align> &&() &&noexcept {
   return std::move(func_);
 }
 
@@ -10,7 +10,7 @@ inline namespace cxx14_v1 {
 namespace detail {
 
 template <typename R, typename F, typename... A>
-void set_state_value(std::shared_ptr<shared_state<R>> &state, F &&f, A &&...a) {
+void set_state_value(state_ptr<shared_state<R>> &state, F &&f, A &&...a) {
   assert(state);
   bool executed = false;
   try {
@@ -27,7 +27,7 @@ void set_state_value(std::shared_ptr<shared_state<R>> &state, F &&f, A &&...a) {
 
 template <typename R, typename F, typename... A>
 std::enable_if_t<!is_future<invoke_result_t<F, A...>>::value>
-set_state_value(std::shared_ptr<shared_state<R &>> &state, F &&f, A &&...a) {
+set_state_value(state_ptr<shared_state<R &>> &state, F &&f, A &&...a) {
   assert(state);
   bool executed = false;
   try {
@@ -44,8 +44,7 @@ set_state_value(std::shared_ptr<shared_state<R &>> &state, F &&f, A &&...a) {
 
 template <typename R, typename F, typename... A>
 std::enable_if_t<is_future<invoke_result_t<F, A...>>::value>
-set_state_value(std::shared_ptr<shared_state<R &>> &state, F &&f,
-                A &&...a) try {
+set_state_value(state_ptr<shared_state<R &>> &state, F &&f, A &&...a) try {
   shared_state<R &>::unwrap(state,
                             ::portable_concurrency::cxx14_v1::detail::invoke(
                                 std::forward<F>(f), std::forward<A>(a)...));
@@ -55,7 +54,7 @@ set_state_value(std::shared_ptr<shared_state<R &>> &state, F &&f,
 
 template <typename F, typename... A>
 std::enable_if_t<std::is_void<invoke_result_t<F, A...>>::value>
-set_state_value(std::shared_ptr<shared_state<void>> &state, F &&f, A &&...a) {
+set_state_value(state_ptr<shared_state<void>> &state, F &&f, A &&...a) {
   assert(state);
   bool executed = false;
   try {
@@ -72,12 +71,12 @@ set_state_value(std::shared_ptr<shared_state<void>> &state, F &&f, A &&...a) {
 
 template <typename F, typename... A>
 std::enable_if_t<!std::is_void<invoke_result_t<F, A...>>::value>
-set_state_value(std::shared_ptr<shared_state<void>> &state, F &&f, A &&...a) {
+set_state_value(state_ptr<shared_state<void>> &state, F &&f, A &&...a) {
   bool executed = false;
   try {
     shared_state<void>::unwrap(
-        state, state_of(::portable_concurrency::cxx14_v1::detail::invoke(
-                   std::forward<F>(f), std::forward<A>(a)...)));
+        state, ::portable_concurrency::cxx14_v1::detail::invoke(
+                   std::forward<F>(f), std::forward<A>(a)...));
   } catch (...) {
     if (executed)
       throw;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
 #include <type_traits>
 #include <utility>
 
@@ -19,17 +20,22 @@ inline namespace cxx14_v1 {
 namespace detail {
 
 template <typename Sequence>
-class when_all_state final : public future_state<Sequence> {
+class when_all_state : public future_state<Sequence> {
 public:
   when_all_state(Sequence &&futures)
       : futures_(std::move(futures)),
         operations_remains_(sequence_traits<Sequence>::size(futures_) + 1) {}
 
-  static std::shared_ptr<future_state<Sequence>> make(Sequence &&futures) {
-    auto state = std::make_shared<when_all_state<Sequence>>(std::move(futures));
-    sequence_traits<Sequence>::for_each(state->futures_, [state](auto &f) {
-      state_of(f)->continuations().push([state] { state->notify(); });
-    });
+  template <typename Alloc>
+  static state_ptr<future_state<Sequence>> make(const Alloc &allocator,
+                                                Sequence &&futures) {
+    auto state = allocate_state<when_all_state<Sequence>>(allocator,
+                                                          std::move(futures));
+    sequence_traits<Sequence>::for_each(
+        state->futures_, [state, &allocator](auto &f) {
+          push_continuation(*state_of(f), [state] { state->notify(); },
+                            allocator);
+        });
     state->notify();
     return state;
   }
@@ -83,7 +89,7 @@ PC_NODISCARD auto when_all(Futures &&...futures)
                         future<std::tuple<std::decay_t<Futures>...>>> {
   using Sequence = std::tuple<std::decay_t<Futures>...>;
   return {detail::when_all_state<Sequence>::make(
-      Sequence{std::forward<Futures>(futures)...})};
+      std::allocator<void>{}, Sequence{std::forward<Futures>(futures)...})};
 }
 #endif
 
@@ -116,6 +122,7 @@ PC_NODISCARD auto when_all(InputIt first, InputIt last) -> std::enable_if_t<
   if (first == last)
     return make_ready_future(Sequence{});
   return {detail::when_all_state<Sequence>::make(
+      std::allocator<void>{},
       Sequence{std::make_move_iterator(first), std::make_move_iterator(last)})};
 }
 
@@ -128,7 +135,8 @@ PC_NODISCARD auto when_all(InputIt first, InputIt last) -> std::enable_if_t<
       std::vector<typename std::iterator_traits<InputIt>::value_type>;
   if (first == last)
     return make_ready_future(Sequence{});
-  return {detail::when_all_state<Sequence>::make(Sequence{first, last})};
+  return {detail::when_all_state<Sequence>::make(std::allocator<void>{},
+                                                 Sequence{first, last})};
 }
 #endif
 
@@ -154,7 +162,61 @@ PC_NODISCARD auto when_all(std::vector<Future, Alloc> futures)
     -> std::enable_if_t<detail::is_future<Future>::value,
                         future<std::vector<Future, Alloc>>> {
   using Sequence = std::vector<Future, Alloc>;
-  return {detail::when_all_state<Sequence>::make(std::move(futures))};
+  return {detail::when_all_state<Sequence>::make(std::allocator<void>{},
+                                                 std::move(futures))};
+}
+#endif
+
+/**
+ * @ingroup future_hdr
+ *
+ * Same as `when_all(futures...)` but the shared state of the returned future
+ * and the nodes of the input futures continuations stacks are allocated with
+ * the `allocator`. [EXTENSION]
+ *
+ * This function template participates in overload resolution only if all of the
+ * `futures` are either `future<T>` or `shared_future<T>`.
+ */
+#ifdef DOXYGEN
+template <typename Alloc, typename... Futures>
+future<std::tuple<Futures...>> when_all(std::allocator_arg_t,
+                                        const Alloc &allocator, Futures &&...);
+#else
+template <typename Alloc, typename... Futures>
+PC_NODISCARD auto when_all(std::allocator_arg_t, const Alloc &allocator,
+                           Futures &&...futures)
+    -> std::enable_if_t<detail::are_futures<std::decay_t<Futures>...>::value,
+                        future<std::tuple<std::decay_t<Futures>...>>> {
+  using Sequence = std::tuple<std::decay_t<Futures>...>;
+  return {detail::when_all_state<Sequence>::make(
+      allocator, Sequence{std::forward<Futures>(futures)...})};
+}
+#endif
+
+/**
+ * @ingroup future_hdr
+ *
+ * Same as `when_all(std::move(futures))` but the shared state of the returned
+ * future and the nodes of the input futures continuations stacks are allocated
+ * with the `allocator`. [EXTENSION]
+ *
+ * This function template participates in overload resolution only if `Future`
+ * is either `future<T>` or `shared_future<T>`.
+ */
+#ifdef DOXYGEN
+template <typename Alloc, typename Future, typename VectorAlloc>
+future<std::vector<Future, VectorAlloc>>
+when_all(std::allocator_arg_t, const Alloc &allocator,
+         std::vector<Future, VectorAlloc> futures);
+#else
+template <typename Alloc, typename Future, typename VectorAlloc>
+PC_NODISCARD auto when_all(std::allocator_arg_t, const Alloc &allocator,
+                           std::vector<Future, VectorAlloc> futures)
+    -> std::enable_if_t<detail::is_future<Future>::value,
+                        future<std::vector<Future, VectorAlloc>>> {
+  using Sequence = std::vector<Future, VectorAlloc>;
+  return {
+      detail::when_all_state<Sequence>::make(allocator, std::move(futures))};
 }
 #endif
 
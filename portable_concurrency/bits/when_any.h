@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <tuple>
 #include <type_traits>
 #include <vector>
@@ -34,7 +35,7 @@ template <typename Sequence> struct when_any_result {
 namespace detail {
 
 template <typename Sequence>
-class when_any_state final : public future_state<when_any_result<Sequence>> {
+class when_any_state : public future_state<when_any_result<Sequence>> {
 public:
   when_any_state(Sequence &&futures)
       : result_{static_cast<std::size_t>(-1), std::move(futures)} {}
@@ -47,14 +48,17 @@ public:
     continuations_.execute();
   }
 
-  static std::shared_ptr<future_state<when_any_result<Sequence>>>
-  make(Sequence &&seq) {
-    auto state = std::make_shared<when_any_state<Sequence>>(std::move(seq));
+  template <typename Alloc>
+  static state_ptr<future_state<when_any_result<Sequence>>>
+  make(const Alloc &allocator, Sequence &&seq) {
+    auto state =
+        allocate_state<when_any_state<Sequence>>(allocator, std::move(seq));
     std::size_t idx = 0;
     sequence_traits<Sequence>::for_each(
-        state->result_.futures, [state, &idx](auto &f) mutable {
-          state_of(f)->continuations().push(
-              [state, pos = idx++] { state->notify(pos); });
+        state->result_.futures, [state, &idx, &allocator](auto &f) mutable {
+          push_continuation(*state_of(f),
+                            [state, pos = idx++] { state->notify(pos); },
+                            allocator);
         });
     if (idx == 0)
       state->continuations_.execute();
@@ -111,7 +115,7 @@ PC_NODISCARD auto when_any(Futures &&...futures) -> std::enable_if_t<
   using Sequence = std::tuple<std::decay_t<Futures>...>;
   return future<when_any_result<Sequence>>{
       detail::when_any_state<Sequence>::make(
-          Sequence{std::forward<Futures>(futures)...})};
+          std::allocator<void>{}, Sequence{std::forward<Futures>(futures)...})};
 }
 #endif
 
@@ -150,8 +154,9 @@ PC_NODISCARD auto when_any(InputIt first, InputIt last) -> std::enable_if_t<
   using Sequence =
       std::vector<typename std::iterator_traits<InputIt>::value_type>;
   return future<when_any_result<Sequence>>{
-      detail::when_any_state<Sequence>::make(Sequence{
-          std::make_move_iterator(first), std::make_move_iterator(last)})};
+      detail::when_any_state<Sequence>::make(
+          std::allocator<void>{}, Sequence{std::make_move_iterator(first),
+                                           std::make_move_iterator(last)})};
 }
 #endif
 
@@ -164,7 +169,8 @@ PC_NODISCARD auto when_any(InputIt first, InputIt last) -> std::enable_if_t<
   using Sequence =
       std::vector<typename std::iterator_traits<InputIt>::value_type>;
   return future<when_any_result<Sequence>>{
-      detail::when_any_state<Sequence>::make(Sequence{first, last})};
+      detail::when_any_state<Sequence>::make(std::allocator<void>{},
+                                             Sequence{first, last})};
 }
 
 #ifdef DOXYGEN
@@ -190,7 +196,64 @@ PC_NODISCARD auto when_any(std::vector<Future, Alloc> futures)
     -> std::enable_if_t<detail::is_future<Future>::value,
                         future<when_any_result<std::vector<Future, Alloc>>>> {
   using Sequence = std::vector<Future, Alloc>;
-  return {detail::when_any_state<Sequence>::make(std::move(futures))};
+  return {detail::when_any_state<Sequence>::make(std::allocator<void>{},
+                                                 std::move(futures))};
+}
+#endif
+
+/**
+ * @ingroup future_hdr
+ *
+ * Same as `when_any(futures...)` but the shared state of the returned future
+ * and the nodes of the input futures continuations stacks are allocated with
+ * the `allocator`. [EXTENSION]
+ *
+ * This function template participates in overload resolution only if all of the
+ * `futures` are either `future<T>` or `shared_future<T>`.
+ */
+#ifdef DOXYGEN
+template <typename Alloc, typename... Futures>
+future<when_any_result<std::tuple<Futures...>>>
+when_any(std::allocator_arg_t, const Alloc &allocator, Futures &&...);
+#else
+template <typename Alloc, typename... Futures>
+PC_NODISCARD auto when_any(std::allocator_arg_t, const Alloc &allocator,
+                           Futures &&...futures)
+    -> std::enable_if_t<
+        detail::are_futures<std::decay_t<Futures>...>::value,
+        future<when_any_result<std::tuple<std::decay_t<Futures>...>>>> {
+  using Sequence = std::tuple<std::decay_t<Futures>...>;
+  return future<when_any_result<Sequence>>{
+      detail::when_any_state<Sequence>::make(
+          allocator, Sequence{std::forward<Futures>(futures)...})};
+}
+#endif
+
+/**
+ * @ingroup future_hdr
+ *
+ * Same as `when_any(std::move(futures))` but the shared state of the returned
+ * future and the nodes of the input futures continuations stacks are allocated
+ * with the `allocator`. [EXTENSION]
+ *
+ * This function template participates in overload resolution only if `Future`
+ * is either `future<T>` or `shared_future<T>`.
+ */
+#ifdef DOXYGEN
+template <typename Alloc, typename Future, typename VectorAlloc>
+future<when_any_result<std::vector<Future, VectorAlloc>>>
+when_any(std::allocator_arg_t, const Alloc &allocator,
+         std::vector<Future, VectorAlloc> futures);
+#else
+template <typename Alloc, typename Future, typename VectorAlloc>
+PC_NODISCARD auto when_any(std::allocator_arg_t, const Alloc &allocator,
+                           std::vector<Future, VectorAlloc> futures)
+    -> std::enable_if_t<
+        detail::is_future<Future>::value,
+        future<when_any_result<std::vector<Future, VectorAlloc>>>> {
+  using Sequence = std::vector<Future, VectorAlloc>;
+  return {
+      detail::when_any_state<Sequence>::make(allocator, std::move(futures))};
 }
 #endif
 
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+namespace detail {
+
+/**
+ * @internal
+ *
+ * Chase-Lev work stealing deque of pointers. Implementation follows "Correct
+ * and Efficient Work-Stealing for Weak Memory Models" by Lê, Pop, Cohen and
+ * Zappa Nardelli.
+ *
+ * @li `push` and `pop` must only be called by the single owner thread and work
+ * on the bottom end of the deque in LIFO order.
+ * @li `steal` can be called by any thread and takes items from the top end of
+ * the deque in FIFO order.
+ *
+ * The deque grows when full. Buffers replaced by a bigger ones are kept alive
+ * until the deque is destroyed since concurrent thieves may still read them.
+ * Deque never owns objects pointed by stored pointers.
+ */
+template <typename T> class work_stealing_deque {
+public:
+  explicit work_stealing_deque(std::size_t capacity = 256) {
+    buffers_.push_back(std::make_unique<buffer>(round_up_pow2(capacity)));
+    buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+  }
+
+  work_stealing_deque(const work_stealing_deque &) = delete;
+  work_stealing_deque &operator=(const work_stealing_deque &) = delete;
+
+  // Owner only
+  void push(T *item) {
+    std::int64_t b = bottom_.load(std::memory_order_relaxed);
+    std::int64_t t = top_.load(std::memory_order_acquire);
+    buffer *buf = buffer_.load(std::memory_order_relaxed);
+    if (b - t > static_cast<std::int64_t>(buf->mask))
+      buf = grow(buf, t, b);
+    buf->put(b, item);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  // Owner only. Returns nullptr if the deque is empty.
+  T *pop() noexcept {
+    std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    buffer *buf = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    T *item = buf->get(b);
+    if (t == b) {
+      // Last item: race against thieves
+      if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed))
+        item = nullptr;
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // Any thread. Returns nullptr if the deque is empty or the race with some
+  // other thread taking the same item is lost.
+  T *steal() noexcept {
+    std::int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b)
+      return nullptr;
+    T *item = buffer_.load(std::memory_order_acquire)->get(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed))
+      return nullptr;
+    return item;
+  }
+
+  // Any thread. Approximate number of items.
+  std::size_t size() const noexcept {
+    std::int64_t b = bottom_.load(std::memory_order_relaxed);
+    std::int64_t t = top_.load(std::memory_order_relaxed);
+    return b > t ? static_cast<std::size_t>(b - t) : 0;
+  }
+
+  bool empty() const noexcept { return size() == 0; }
+
+private:
+  struct buffer {
+    explicit buffer(std::size_t capacity)
+        : mask{capacity - 1}, slots{new std::atomic<T *>[capacity]} {}
+
+    T *get(std::int64_t idx) const noexcept {
+      return slots[static_cast<std::size_t>(idx) & mask].load(
+          std::memory_order_relaxed);
+    }
+
+    void put(std::int64_t idx, T *item) noexcept {
+      slots[static_cast<std::size_t>(idx) & mask].store(
+          item, std::memory_order_relaxed);
+    }
+
+    const std::size_t mask;
+    std::unique_ptr<std::atomic<T *>[]> slots;
+  };
+
+  static std::size_t round_up_pow2(std::size_t val) noexcept {
+    std::size_t res = 2;
+    while (res < val)
+      res <<= 1;
+    return res;
+  }
+
+  buffer *grow(buffer *old, std::int64_t t, std::int64_t b) {
+    buffers_.push_back(std::make_unique<buffer>((old->mask + 1) * 2));
+    buffer *res = buffers_.back().get();
+    for (std::int64_t i = t; i < b; ++i)
+      res->put(i, old->get(i));
+    buffer_.store(res, std::memory_order_release);
+    return res;
+  }
+
+private:
+  // top_ is written by thieves while bottom_ is written by the owner only: keep
+  // them on separate cache lines.
+  std::atomic<std::int64_t> top_{0};
+  char padding_[64 - sizeof(std::atomic<std::int64_t>)];
+  std::atomic<std::int64_t> bottom_{0};
+  std::atomic<buffer *> buffer_{nullptr};
+  // Owner only
+  std::vector<std::unique_ptr<buffer>> buffers_;
+};
+
+} // namespace detail
+} // namespace cxx14_v1
+} // namespace portable_concurrency
@@ -4,6 +4,7 @@
 
 #include <portable_concurrency/future>
 
+#include "simple_arena_allocator.h"
 #include "test_tools.h"
 
 using namespace std::literals;
@@ -62,6 +63,18 @@ TEST_F(Async, destroys_function_object_after_invocation) {
   EXPECT_TRUE(wp.expired());
 }
 
+TEST_F(Async, state_is_allocated_with_provided_allocator) {
+  static_arena<1024> arena;
+  arena_allocator<void, static_arena<1024>> alloc{arena};
+  pc::future<int> future =
+      pc::async(std::allocator_arg, alloc, g_future_tests_env,
+                [](int a, int b) { return a + b; }, 40, 2);
+  EXPECT_GT(arena.used(), 0u);
+  EXPECT_EQ(future.get(), 42);
+  // Worker thread may still own the task allocated from the arena
+  g_future_tests_env->wait_current_tasks();
+}
+
 } // namespace test
 } // anonymous namespace
 } // namespace portable_concurrency
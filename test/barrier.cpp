@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <portable_concurrency/barrier>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr ptrdiff_t threads_count = 4;
+constexpr int phases_count = 100;
+
+TEST(Barrier, no_thread_passes_barrier_before_all_threads_arrive) {
+  pc::barrier barrier{threads_count};
+  std::atomic<int> arrived{0};
+  std::atomic<bool> failed{false};
+  std::vector<std::thread> threads;
+  for (ptrdiff_t i = 0; i < threads_count; ++i) {
+    threads.emplace_back([&] {
+      for (int phase = 1; phase <= phases_count; ++phase) {
+        arrived.fetch_add(1, std::memory_order_relaxed);
+        barrier.arrive_and_wait();
+        if (arrived.load(std::memory_order_relaxed) < phase * threads_count)
+          failed = true;
+        barrier.arrive_and_wait();
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  EXPECT_FALSE(failed);
+  EXPECT_EQ(arrived.load(), phases_count * threads_count);
+}
+
+TEST(Barrier, dropped_thread_does_not_participate_in_next_phases) {
+  pc::barrier barrier{threads_count};
+  std::vector<std::thread> threads;
+  for (ptrdiff_t i = 0; i < threads_count - 1; ++i) {
+    threads.emplace_back([&] {
+      for (int phase = 0; phase < phases_count; ++phase)
+        barrier.arrive_and_wait();
+    });
+  }
+  barrier.arrive_and_drop();
+  for (auto &thread : threads)
+    thread.join();
+}
+
+TEST(FlexBarrier, completion_is_called_once_per_phase) {
+  std::atomic<int> completions{0};
+  pc::flex_barrier barrier{threads_count, [&completions]() -> ptrdiff_t {
+                             completions.fetch_add(1);
+                             return -1;
+                           }};
+  std::vector<std::thread> threads;
+  for (ptrdiff_t i = 0; i < threads_count; ++i) {
+    threads.emplace_back([&] {
+      for (int phase = 1; phase <= phases_count; ++phase) {
+        barrier.arrive_and_wait();
+        EXPECT_GE(completions.load(), phase);
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  EXPECT_EQ(completions.load(), phases_count);
+}
+
+TEST(FlexBarrier, completion_changes_number_of_participating_threads) {
+  pc::flex_barrier barrier{threads_count, []() -> ptrdiff_t { return 1; }};
+  std::vector<std::thread> threads;
+  for (ptrdiff_t i = 0; i < threads_count - 1; ++i)
+    threads.emplace_back([&] { barrier.arrive_and_wait(); });
+  barrier.arrive_and_wait();
+  for (auto &thread : threads)
+    thread.join();
+  // Only this thread participates in the subsequent phases
+  for (int phase = 0; phase < phases_count; ++phase)
+    barrier.arrive_and_wait();
+}
+
+TEST(FlexBarrier, exception_from_completion_terminates) {
+  ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+  pc::flex_barrier barrier{1, []() -> ptrdiff_t {
+                             throw std::runtime_error{"completion"};
+                           }};
+  EXPECT_DEATH(barrier.arrive_and_wait(), "");
+}
+
+TEST(Barrier, can_be_destroyed_right_after_arrive_and_wait_returns) {
+  for (int i = 0; i < 100; ++i) {
+    std::thread thread;
+    {
+      pc::barrier barrier{2};
+      thread = std::thread{[&barrier] { barrier.arrive_and_wait(); }};
+      barrier.arrive_and_wait();
+    }
+    thread.join();
+  }
+}
+
+} // anonymous namespace
@@ -0,0 +1,79 @@
+#include <atomic>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <portable_concurrency/future>
+
+#include "test_tools.h"
+
+namespace portable_concurrency {
+namespace {
+namespace test {
+
+struct BulkAsync : future_test {};
+
+TEST_F(BulkAsync, delivers_results_in_index_order) {
+  pc::future<std::vector<std::string>> future = pc::bulk_async(
+      g_future_tests_env, 100, [](std::size_t i) { return std::to_string(i); });
+  const std::vector<std::string> res = future.get();
+  ASSERT_EQ(res.size(), 100u);
+  for (std::size_t i = 0; i < res.size(); ++i)
+    EXPECT_EQ(res[i], std::to_string(i));
+}
+
+TEST_F(BulkAsync, runs_every_invocation_on_specified_executor) {
+  pc::future<std::vector<bool>> future =
+      pc::bulk_async(g_future_tests_env, 10, [](std::size_t) {
+        return g_future_tests_env->uses_thread(std::this_thread::get_id());
+      });
+  for (bool uses_executor_thread : future.get())
+    EXPECT_TRUE(uses_executor_thread);
+}
+
+TEST_F(BulkAsync, void_future_becomes_ready_after_all_invocations) {
+  std::atomic<int> counter{0};
+  pc::future<void> future =
+      pc::bulk_async(g_future_tests_env, 50, [&counter](std::size_t) {
+        ++counter;
+      });
+  future.get();
+  EXPECT_EQ(counter.load(), 50);
+}
+
+TEST_F(BulkAsync, zero_invocations_give_ready_future) {
+  pc::future<std::vector<int>> future = pc::bulk_async(
+      g_future_tests_env, 0, [](std::size_t) -> int { throw 42; });
+  ASSERT_TRUE(future.is_ready());
+  EXPECT_TRUE(future.get().empty());
+}
+
+TEST_F(BulkAsync, delivers_exception_from_invocation) {
+  pc::future<void> future =
+      pc::bulk_async(g_future_tests_env, 10, [](std::size_t i) {
+        if (i == 5)
+          throw std::runtime_error("Ooups");
+      });
+  EXPECT_RUNTIME_ERROR(future, "Ooups");
+}
+
+TEST_F(BulkAsync, works_with_inplace_executor) {
+  pc::future<std::vector<std::size_t>> future = pc::bulk_async(
+      pc::inplace_executor, 3, [](std::size_t i) { return i * i; });
+  ASSERT_TRUE(future.is_ready());
+  EXPECT_EQ(future.get(), (std::vector<std::size_t>{0, 1, 4}));
+}
+
+TEST_F(BulkAsync, move_only_results_are_supported) {
+  pc::future<std::vector<std::unique_ptr<int>>> future =
+      pc::bulk_async(g_future_tests_env, 3, [](std::size_t i) {
+        return std::make_unique<int>(static_cast<int>(i));
+      });
+  const auto res = future.get();
+  ASSERT_EQ(res.size(), 3u);
+  EXPECT_EQ(*res[2], 2);
+}
+
+} // namespace test
+} // namespace
+} // namespace portable_concurrency
@@ -191,6 +191,29 @@ TEST(Promise, is_awaiten_returns_false_after_continuation_future_destroyed) {
   EXPECT_FALSE(p.first.is_awaiten());
 }
 
+TEST(ContinuationCancelation,
+     continuation_is_destroyed_on_future_destruction_while_promise_is_alive) {
+  auto val = std::make_shared<int>(42);
+  std::weak_ptr<int> weak = val;
+  auto p = pc::make_promise<int>();
+  {
+    auto f = p.second.next([val = std::move(val)](int) {});
+  }
+  EXPECT_FALSE(weak.lock());
+}
+
+TEST(Promise, is_awaiten_returns_false_after_unwrapped_future_destroyed) {
+  auto inner = pc::make_promise<int>();
+  auto outer = pc::make_promise<int>();
+  {
+    auto f = outer.second.next(
+        [&inner](int) { return std::move(inner.second); });
+    outer.first.set_value(42);
+    EXPECT_TRUE(inner.first.is_awaiten());
+  }
+  EXPECT_FALSE(inner.first.is_awaiten());
+}
+
 TEST(FutureDetach, invalidates_future) {
   auto p = pc::make_promise<int>();
   p.second.detach();
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+
+#include <portable_concurrency/closable_queue>
+
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace {
+
+TEST(ClosableQueue, pops_values_in_fifo_order) {
+  pc::closable_queue<int> queue;
+  for (int i = 0; i < 5; ++i)
+    EXPECT_TRUE(queue.push(std::move(i)));
+
+  int val = -1;
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(queue.pop(val));
+    EXPECT_EQ(val, i);
+  }
+}
+
+TEST(ClosableQueue, try_pop_fails_on_empty_queue) {
+  pc::closable_queue<int> queue;
+  int val = -1;
+  EXPECT_FALSE(queue.try_pop(val));
+  EXPECT_EQ(val, -1);
+}
+
+TEST(ClosableQueue, unbounded_queue_preserves_order_beyond_ring_capacity) {
+  constexpr int count = 5000;
+  pc::closable_queue<int> queue;
+  for (int i = 0; i < count; ++i)
+    ASSERT_TRUE(queue.try_push(std::move(i)));
+
+  int val = -1;
+  for (int i = 0; i < count; ++i) {
+    ASSERT_TRUE(queue.try_pop(val));
+    EXPECT_EQ(val, i);
+  }
+  EXPECT_FALSE(queue.try_pop(val));
+}
+
+TEST(ClosableQueue, push_to_closed_queue_fails) {
+  pc::closable_queue<std::unique_ptr<int>> queue;
+  queue.close();
+
+  auto val = std::make_unique<int>(42);
+  EXPECT_FALSE(queue.push(std::move(val)));
+  EXPECT_FALSE(queue.try_push(std::move(val)));
+  ASSERT_TRUE(val);
+  EXPECT_TRUE(queue.is_closed());
+}
+
+TEST(ClosableQueue, values_pushed_before_close_are_consumed) {
+  pc::closable_queue<int> queue;
+  queue.push(1);
+  queue.push(2);
+  queue.close();
+
+  int val = 0;
+  EXPECT_TRUE(queue.pop(val));
+  EXPECT_EQ(val, 1);
+  EXPECT_TRUE(queue.pop(val));
+  EXPECT_EQ(val, 2);
+  EXPECT_FALSE(queue.pop(val));
+}
+
+TEST(ClosableQueue, close_wakes_up_waiting_consumer) {
+  pc::closable_queue<int> queue;
+  std::thread consumer{[&queue] {
+    int val;
+    EXPECT_FALSE(queue.pop(val));
+  }};
+  std::this_thread::sleep_for(std::chrono::milliseconds{5});
+  queue.close();
+  consumer.join();
+}
+
+TEST(ClosableQueue, try_push_to_full_bounded_queue_fails) {
+  pc::closable_queue<int> queue{2};
+  EXPECT_TRUE(queue.try_push(1));
+  EXPECT_TRUE(queue.try_push(2));
+  EXPECT_FALSE(queue.try_push(3));
+
+  int val = 0;
+  EXPECT_TRUE(queue.try_pop(val));
+  EXPECT_TRUE(queue.try_push(3));
+}
+
+TEST(ClosableQueue, push_to_full_bounded_queue_waits_for_consumer) {
+  pc::closable_queue<int> queue{2};
+  queue.push(1);
+  queue.push(2);
+  std::atomic<bool> pushed{false};
+  std::thread producer{[&] {
+    EXPECT_TRUE(queue.push(3));
+    pushed = true;
+  }};
+  std::this_thread::sleep_for(std::chrono::milliseconds{5});
+  EXPECT_FALSE(pushed.load());
+
+  int val = 0;
+  EXPECT_TRUE(queue.pop(val));
+  producer.join();
+  EXPECT_TRUE(pushed.load());
+}
+
+TEST(ClosableQueue, close_wakes_up_producer_waiting_on_full_queue) {
+  pc::closable_queue<int> queue{2};
+  queue.push(1);
+  queue.push(2);
+  std::thread producer{[&queue] { EXPECT_FALSE(queue.push(3)); }};
+  std::this_thread::sleep_for(std::chrono::milliseconds{5});
+  queue.close();
+  producer.join();
+}
+
+TEST(ClosableQueue, all_values_are_delivered_to_concurrent_consumers) {
+  constexpr int producers_count = 3;
+  constexpr int consumers_count = 3;
+  constexpr int values_per_producer = 10000;
+
+  pc::closable_queue<int> queue{64};
+  std::vector<long long> sums(consumers_count, 0);
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < consumers_count; ++i) {
+    consumers.emplace_back([&queue, &sum = sums[i]] {
+      int val;
+      while (queue.pop(val))
+        sum += val;
+    });
+  }
+  std::vector<std::thread> producers;
+  for (int i = 0; i < producers_count; ++i) {
+    producers.emplace_back([&queue] {
+      for (int val = 1; val <= values_per_producer; ++val)
+        queue.push(std::move(val));
+    });
+  }
+  for (auto &producer : producers)
+    producer.join();
+  queue.close();
+  for (auto &consumer : consumers)
+    consumer.join();
+
+  const long long expected = static_cast<long long>(producers_count) *
+                             values_per_producer * (values_per_producer + 1) /
+                             2;
+  EXPECT_EQ(std::accumulate(sums.begin(), sums.end(), 0ll), expected);
+}
+
+} // namespace
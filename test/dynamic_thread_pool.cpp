@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <portable_concurrency/future>
+#include <portable_concurrency/latch>
+#include <portable_concurrency/thread_pool>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+TEST(DynamicThreadPool, executes_tasks) {
+  pc::dynamic_thread_pool pool{1, 4};
+  pc::future<std::thread::id> tid =
+      pc::async(pool.executor(), [] { return std::this_thread::get_id(); });
+  EXPECT_NE(tid.get(), std::this_thread::get_id());
+}
+
+TEST(DynamicThreadPool, starts_min_threads) {
+  pc::dynamic_thread_pool pool{3, 4};
+  EXPECT_EQ(pool.size(), 3u);
+}
+
+TEST(DynamicThreadPool, rejects_invalid_threads_limits) {
+  EXPECT_THROW(pc::dynamic_thread_pool(0, 0), std::invalid_argument);
+  EXPECT_THROW(pc::dynamic_thread_pool(4, 2), std::invalid_argument);
+}
+
+TEST(DynamicThreadPool, grows_when_tasks_are_queued) {
+  static constexpr size_t task_count = 4;
+
+  pc::latch latch{task_count + 1};
+  pc::dynamic_thread_pool pool{0, task_count};
+  for (size_t i = 0; i < task_count; ++i)
+    post(pool.executor(), [&latch] { latch.count_down_and_wait(); });
+
+  // Each task waits for all of the others so they must run concurrently
+  latch.count_down_and_wait();
+  EXPECT_GE(pool.size(), task_count);
+}
+
+TEST(DynamicThreadPool, worker_blocked_on_future_does_not_deadlock_pool) {
+  pc::dynamic_thread_pool pool{1, 1};
+  auto exec = pool.executor();
+
+  pc::future<int> res = pc::async(exec, [exec] {
+    return pc::async(exec, [] { return 42; }).get();
+  });
+
+  EXPECT_EQ(res.get(), 42);
+}
+
+TEST(DynamicThreadPool, shrinks_to_min_threads_when_idle) {
+  static constexpr size_t task_count = 4;
+
+  pc::latch latch{task_count + 1};
+  pc::dynamic_thread_pool pool{1, task_count, std::chrono::milliseconds{10}};
+  for (size_t i = 0; i < task_count; ++i)
+    post(pool.executor(), [&latch] { latch.count_down_and_wait(); });
+  latch.count_down_and_wait();
+
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds{5};
+  while (pool.size() > 1 && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds{5});
+  EXPECT_EQ(pool.size(), 1u);
+}
+
+TEST(DynamicThreadPool, processes_all_queued_tasks_when_waited_on) {
+  static constexpr size_t task_count = 100;
+
+  std::atomic<size_t> executed{0};
+  pc::dynamic_thread_pool pool{1, 2};
+  for (size_t i = 0; i < task_count; ++i)
+    post(pool.executor(), [&executed] { ++executed; });
+  pool.wait();
+
+  EXPECT_EQ(executed.load(), task_count);
+  EXPECT_EQ(pool.size(), 0u);
+}
+
+TEST(DynamicThreadPool, wait_joins_worker_threads) {
+  static std::atomic<bool> destroyed{false};
+  struct thread_local_object {
+    ~thread_local_object() {
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      destroyed = true;
+    }
+  };
+
+  pc::dynamic_thread_pool pool{1, 1};
+  pc::async(pool.executor(), [] {
+    static thread_local thread_local_object object;
+    (void)object;
+  }).get();
+  pool.wait();
+
+  EXPECT_TRUE(destroyed.load());
+}
+
+TEST(DynamicThreadPool, abandoned_tasks_break_promises) {
+  pc::latch started{2};
+  pc::latch release{1};
+  pc::future<int> abandoned;
+  {
+    pc::dynamic_thread_pool pool{1, 1};
+    post(pool.executor(), [&] {
+      started.count_down();
+      release.wait();
+    });
+    started.count_down_and_wait();
+    abandoned = pc::async(pool.executor(), [] { return 42; });
+    pool.stop();
+    release.count_down();
+  }
+
+  EXPECT_THROW(abandoned.get(), std::future_error);
+}
+
+} // namespace
@@ -97,6 +97,61 @@ TEST_F(future, is_ready_return_false_on_nonready) {
   EXPECT_FALSE(future.is_ready());
 }
 
+TEST_F(future, blocking_wait_does_not_allocate) {
+  auto p = pc::make_promise<int>();
+  pc::shared_future<int> f = p.second.share();
+  // Occupy inline slot of the continuations stack
+  pc::future<int> cnt_f = f.next([](int val) { return val + 1; });
+  std::thread producer{[promise = std::move(p.first)]() mutable {
+    std::this_thread::sleep_for(std::chrono::milliseconds{5});
+    promise.set_value(42);
+  }};
+  const auto before = allocations_count();
+  f.wait();
+  EXPECT_EQ(allocations_count() - before, 0u);
+  producer.join();
+  EXPECT_EQ(cnt_f.get(), 43);
+}
+
+TEST_F(future, ready_future_does_not_allocate_shared_state) {
+  const auto before = allocations_count();
+  pc::future<int> f = pc::make_ready_future(42);
+  EXPECT_TRUE(f.is_ready());
+  EXPECT_EQ(f.get(), 42);
+  pc::future<void> v = pc::make_ready_future();
+  EXPECT_TRUE(v.is_ready());
+  v.get();
+  EXPECT_EQ(allocations_count() - before, 0u);
+}
+
+struct incomplete;
+struct future_holder {
+  pc::future<incomplete> future;
+};
+
+TEST_F(future, no_inline_storage_for_class_types) {
+  static_assert(sizeof(pc::future<std::string>) ==
+                    sizeof(pc::future<incomplete>),
+                "future of class type must not store the value inline");
+  static_assert(noexcept(std::declval<pc::future<std::string> &>().share()),
+                "future of class type must be shared without allocation");
+  static_assert(std::is_nothrow_constructible<pc::shared_future<std::string>,
+                                              pc::future<std::string>>::value,
+                "future of class type must be shared without allocation");
+  future_holder holder;
+  EXPECT_FALSE(holder.future.valid());
+}
+
+TEST_F(future, ready_future_unwrapped_into_continuation_without_allocation) {
+  auto p = pc::make_promise<int>();
+  pc::future<int> f = p.second.then(
+      [](pc::future<int> f) { return pc::make_ready_future(f.get() + 1); });
+  const auto before = allocations_count();
+  p.first.set_value(1);
+  EXPECT_EQ(allocations_count() - before, 0u);
+  EXPECT_EQ(f.get(), 2);
+}
+
 template <typename T> struct FutureTests : ::testing::Test {
   pc::promise<T> promise[2];
 };
@@ -388,4 +443,43 @@ TYPED_TEST(FutureTests, error_future_maker_from_caught_exception) {
   EXPECT_FALSE(future.valid());
 }
 
+TYPED_TEST(FutureTests, ready_future_can_be_shared) {
+  pc::shared_future<TypeParam> future = make_some_ready_future<TypeParam>();
+  ASSERT_TRUE(future.valid());
+  EXPECT_TRUE(future.is_ready());
+  EXPECT_SOME_VALUE(future);
+}
+
+TYPED_TEST(FutureTests, exceptional_future_can_be_shared) {
+  pc::shared_future<TypeParam> future =
+      pc::make_exceptional_future<TypeParam>(std::runtime_error("test error"));
+  ASSERT_TRUE(future.valid());
+  EXPECT_TRUE(future.is_ready());
+  EXPECT_RUNTIME_ERROR(future, "test error");
+}
+
+TYPED_TEST(FutureTests, ready_future_value_is_passed_to_continuation) {
+  pc::future<TypeParam> future =
+      make_some_ready_future<TypeParam>().then([](pc::future<TypeParam> f) {
+        return f;
+      });
+  ASSERT_TRUE(future.is_ready());
+  EXPECT_SOME_VALUE(future);
+}
+
+TYPED_TEST(FutureTests, ready_future_notifies_immediately) {
+  auto future = make_some_ready_future<TypeParam>();
+  bool notified = false;
+  future.notify([&notified] { notified = true; });
+  EXPECT_TRUE(notified);
+  EXPECT_SOME_VALUE(future);
+}
+
+TYPED_TEST(FutureTests, detached_ready_future_keeps_value) {
+  auto future = make_some_ready_future<TypeParam>().detach();
+  ASSERT_TRUE(future.valid());
+  EXPECT_SOME_VALUE(future);
+  EXPECT_FALSE(future.valid());
+}
+
 } // anonymous namespace
@@ -6,6 +6,7 @@
 
 #include <portable_concurrency/future>
 
+#include "simple_arena_allocator.h"
 #include "test_helpers.h"
 #include "test_tools.h"
 
@@ -50,6 +51,21 @@ TEST_F(FutureNext, exception_propagated_to_result_of_next) {
   EXPECT_RUNTIME_ERROR(cnt_f, "Ooups");
 }
 
+TEST_F(FutureNext, continuation_is_not_called_for_exceptional_ready_future) {
+  unsigned call_count = 0;
+  pc::future<void> cnt_f =
+      pc::make_exceptional_future<int>(std::runtime_error{"Ooups"})
+          .next([&call_count](int) { ++call_count; });
+  EXPECT_EQ(call_count, 0u);
+  EXPECT_RUNTIME_ERROR(cnt_f, "Ooups");
+}
+
+TEST_F(FutureNext, continuation_of_ready_future_is_executed_immediately) {
+  pc::future<int> cnt_f = pc::make_ready_future().next([] { return 42; });
+  ASSERT_TRUE(cnt_f.is_ready());
+  EXPECT_EQ(cnt_f.get(), 42);
+}
+
 TEST_F(FutureNext, is_executed_for_void_future) {
   pc::promise<void> void_promise;
   pc::future<void> void_future = void_promise.get_future();
@@ -99,6 +115,29 @@ TEST_F(FutureNext, desroys_continuation_after_invocation) {
   EXPECT_TRUE(wp.expired());
 }
 
+TEST_F(FutureNext, continuation_state_is_allocated_with_provided_allocator) {
+  static_arena<1024> arena;
+  arena_allocator<void, static_arena<1024>> alloc{arena};
+  pc::future<std::string> cnt_f = future.next(
+      std::allocator_arg, alloc, [](int val) { return to_string(val); });
+  EXPECT_GT(arena.used(), 0u);
+  promise.set_value(42);
+  EXPECT_EQ(cnt_f.get(), "42");
+}
+
+TEST_F(FutureNext, void_continuation_state_is_allocated_with_allocator) {
+  static_arena<1024> arena;
+  arena_allocator<void, static_arena<1024>> alloc{arena};
+  auto p = pc::make_promise<void>();
+  pc::future<int> cnt_f = p.second.next(std::allocator_arg, alloc,
+                                        g_future_tests_env, [] { return 42; });
+  EXPECT_GT(arena.used(), 0u);
+  p.first.set_value();
+  EXPECT_EQ(cnt_f.get(), 42);
+  // Worker thread may still own the continuation allocated from the arena
+  g_future_tests_env->wait_current_tasks();
+}
+
 } // namespace test
 } // anonymous namespace
 } // namespace portable_concurrency
@@ -1,6 +1,7 @@
 #include <future>
 #include <memory>
 #include <string>
+#include <thread>
 
 #include <gtest/gtest.h>
 
@@ -15,6 +16,27 @@ namespace test {
 
 std::string stringify(pc::future<int> f) { return to_string(f.get()); }
 
+template <typename T> struct counting_allocator {
+  using value_type = T;
+
+  counting_allocator(int &counter) : counter(counter) {}
+  template <typename U>
+  counting_allocator(const counting_allocator<U> &rhs)
+      : counter(rhs.counter) {}
+
+  T *allocate(std::size_t n) {
+    ++counter.get();
+    return std::allocator<T>{}.allocate(n);
+  }
+
+  void deallocate(T *ptr, std::size_t n) {
+    --counter.get();
+    std::allocator<T>{}.deallocate(ptr, n);
+  }
+
+  std::reference_wrapper<int> counter;
+};
+
 struct FutureThen : future_test {
   pc::promise<int> promise;
   pc::future<int> future = promise.get_future();
@@ -163,6 +185,32 @@ TEST_F(FutureThen, exception_to_ready_continuation) {
   string_f.get();
 }
 
+TEST_F(FutureThen, continuation_of_ready_future_runs_on_calling_thread) {
+  pc::future<std::thread::id> cnt_f = pc::make_ready_future(42).then(
+      [](pc::future<int>) { return std::this_thread::get_id(); });
+  ASSERT_TRUE(cnt_f.is_ready());
+  EXPECT_EQ(cnt_f.get(), std::this_thread::get_id());
+}
+
+TEST_F(FutureThen, exception_from_continuation_of_ready_future_is_delivered) {
+  pc::future<int> cnt_f =
+      pc::make_ready_future(42).then([](pc::future<int>) -> int {
+        throw std::runtime_error("continuation error");
+      });
+  ASSERT_TRUE(cnt_f.is_ready());
+  EXPECT_RUNTIME_ERROR(cnt_f, "continuation error");
+}
+
+TEST_F(FutureThen, future_returned_by_continuation_of_ready_future_unwrapped) {
+  set_promise_value(promise);
+  auto inner = pc::make_promise<std::string>();
+  pc::future<std::string> cnt_f = future.then(
+      [&inner](pc::future<int>) { return std::move(inner.second); });
+  EXPECT_FALSE(cnt_f.is_ready());
+  inner.first.set_value("Hello");
+  EXPECT_EQ(cnt_f.get(), "Hello");
+}
+
 TEST_F(FutureThen, run_continuation_on_specific_executor) {
   pc::future<std::thread::id> cnt_f =
       future.then(g_future_tests_env,
@@ -182,6 +230,80 @@ TEST_F(FutureThen, desroys_continuation_after_invocation) {
   EXPECT_TRUE(wp.expired());
 }
 
+TEST_F(FutureThen, continuation_state_is_allocated_with_provided_allocator) {
+  const auto used = arena.used();
+  pc::future<std::size_t> cnt_f = alloc_future.then(
+      std::allocator_arg, allocator,
+      [](pc::future<std::string> f) { return f.get().size(); });
+  EXPECT_GT(arena.used(), used);
+  alloc_promise.set_value("Hello");
+  EXPECT_EQ(cnt_f.get(), 5u);
+}
+
+TEST_F(FutureThen, continuation_with_allocator_runs_on_specified_executor) {
+  pc::future<std::thread::id> cnt_f =
+      future.then(std::allocator_arg, allocator, g_future_tests_env,
+                  [](pc::future<int>) { return std::this_thread::get_id(); });
+  EXPECT_GT(arena.used(), 0u);
+  set_promise_value(promise);
+  EXPECT_TRUE(g_future_tests_env->uses_thread(cnt_f.get()));
+  // Worker thread may still own the continuation allocated from the arena
+  g_future_tests_env->wait_current_tasks();
+}
+
+TEST_F(FutureThen, interruptible_continuation_is_allocated_with_allocator) {
+  const auto used = arena.used();
+  pc::future<int> cnt_f = future.then(
+      std::allocator_arg, allocator,
+      [](pc::promise<int> p, pc::future<int> f) { p.set_value(2 * f.get()); });
+  EXPECT_GT(arena.used(), used);
+  promise.set_value(21);
+  EXPECT_EQ(cnt_f.get(), 42);
+}
+
+TEST_F(FutureThen, allocator_is_used_for_continuation_stack_nodes) {
+  pc::shared_future<int> cnt_f =
+      future
+          .then(std::allocator_arg, allocator,
+                [](pc::future<int> f) { return f.get(); })
+          .share();
+  // First continuation is stored inline in the continuations stack
+  pc::future<int> res1 = cnt_f.next([](int val) { return val + 1; });
+  const auto used = arena.used();
+  pc::future<int> res2 = cnt_f.next([](int val) { return val + 2; });
+  EXPECT_GT(arena.used(), used);
+  promise.set_value(40);
+  EXPECT_EQ(res1.get(), 41);
+  EXPECT_EQ(res2.get(), 42);
+}
+
+TEST_F(FutureThen, all_memory_of_continuations_chain_is_released) {
+  int allocations = 0;
+  counting_allocator<void> alloc{allocations};
+  {
+    auto p = pc::make_promise<int>();
+    pc::future<std::string> f =
+        p.second
+            .then(std::allocator_arg, alloc,
+                  [](pc::future<int> f) { return f.get() + 1; })
+            .then(std::allocator_arg, alloc,
+                  [](pc::future<int> f) { return std::to_string(f.get()); });
+    EXPECT_GT(allocations, 0);
+    p.first.set_value(41);
+    EXPECT_EQ(f.get(), "42");
+  }
+  EXPECT_EQ(allocations, 0);
+}
+
+TEST_F(FutureThen, ready_continuations_chain_does_not_allocate) {
+  const auto before = allocations_count();
+  pc::future<int> f = pc::make_ready_future(1)
+                          .then([](pc::future<int> f) { return f.get() + 1; })
+                          .next([](int val) { return 2 * val; });
+  EXPECT_EQ(f.get(), 4);
+  EXPECT_EQ(allocations_count() - before, 0u);
+}
+
 } // namespace test
 } // anonymous namespace
 } // namespace portable_concurrency
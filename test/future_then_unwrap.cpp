@@ -1,4 +1,8 @@
+#include <deque>
+#include <functional>
 #include <future>
+#include <memory>
+#include <string>
 
 #include <gtest/gtest.h>
 
@@ -10,6 +14,52 @@ namespace portable_concurrency {
 namespace {
 namespace test {
 
+template <typename T> struct counting_allocator {
+  using value_type = T;
+
+  counting_allocator(int &counter) : counter(counter) {}
+  template <typename U>
+  counting_allocator(const counting_allocator<U> &rhs)
+      : counter(rhs.counter) {}
+
+  T *allocate(std::size_t n) {
+    ++counter.get();
+    return std::allocator<T>{}.allocate(n);
+  }
+
+  void deallocate(T *ptr, std::size_t n) {
+    --counter.get();
+    std::allocator<T>{}.deallocate(ptr, n);
+  }
+
+  std::reference_wrapper<int> counter;
+};
+
+// Asynchronous loop of continuations each returning the future of the next
+// iteration. Continuation states are counted with the allocator.
+struct async_loop {
+  pc::future<int> run(int iterations, int acc = 0) {
+    if (iterations == 0)
+      return pc::make_ready_future(acc);
+    auto p = pc::make_promise<int>();
+    promises.push_back(std::move(p.first));
+    return p.second.then(std::allocator_arg,
+                         counting_allocator<void>{allocations},
+                         [this, iterations, acc](pc::future<int> f) {
+                           return run(iterations - 1, acc + f.get());
+                         });
+  }
+
+  void step(int val) {
+    auto p = std::move(promises.front());
+    promises.pop_front();
+    p.set_value(val);
+  }
+
+  std::deque<pc::promise<int>> promises;
+  int allocations = 0;
+};
+
 struct FutureThenUnwrap : future_test {
   FutureThenUnwrap() { std::tie(promise, future) = pc::make_promise<int>(); }
   pc::promise<int> promise;
@@ -93,6 +143,73 @@ TEST_F(FutureThenUnwrap,
   EXPECT_EQ(&inner_future.get(), &cnt_f.get());
 }
 
+TEST_F(FutureThenUnwrap, async_recursion_does_not_accumulate_states) {
+  async_loop loop;
+  pc::future<int> res = loop.run(100);
+  for (int i = 0; i < 100; ++i) {
+    loop.step(1);
+    // Outer continuation state and the one of current iteration
+    EXPECT_LE(loop.allocations, 2) << "iteration " << i;
+  }
+  ASSERT_TRUE(res.is_ready());
+  EXPECT_EQ(res.get(), 100);
+  EXPECT_EQ(loop.allocations, 0);
+}
+
+TEST_F(FutureThenUnwrap, async_recursion_propagates_error) {
+  async_loop loop;
+  pc::future<int> res = loop.run(10);
+  for (int i = 0; i < 5; ++i)
+    loop.step(1);
+  EXPECT_FALSE(res.is_ready());
+  loop.promises.front().set_exception(
+      std::make_exception_ptr(std::runtime_error{"Ooups"}));
+  EXPECT_RUNTIME_ERROR(res, "Ooups");
+}
+
+TEST_F(FutureThenUnwrap, async_recursion_result_abandon_cancels_iteration) {
+  async_loop loop;
+  pc::future<int> res = loop.run(10);
+  for (int i = 0; i < 5; ++i)
+    loop.step(1);
+  EXPECT_TRUE(loop.promises.front().is_awaiten());
+  res = {};
+  EXPECT_FALSE(loop.promises.front().is_awaiten());
+  EXPECT_EQ(loop.allocations, 0);
+}
+
+TEST_F(FutureThenUnwrap, continuations_of_forwarding_future_are_executed) {
+  auto mid_promise = pc::make_promise<int>();
+  auto inner_promise = pc::make_promise<std::string>();
+  bool notified = false;
+  pc::future<std::string> cnt_f = future.then([&](pc::future<int>) {
+    pc::future<std::string> mid_f = mid_promise.second.then(
+        [&](pc::future<int>) { return std::move(inner_promise.second); });
+    mid_f.notify([&] { notified = true; });
+    return mid_f;
+  });
+  promise.set_value(42);
+  mid_promise.first.set_value(1);
+  EXPECT_FALSE(notified);
+  EXPECT_FALSE(cnt_f.is_ready());
+  inner_promise.first.set_value("qwe");
+  EXPECT_TRUE(notified);
+  EXPECT_EQ(cnt_f.get(), "qwe");
+}
+
+TEST_F(FutureThenUnwrap, async_recursion_on_thread_pool) {
+  std::function<pc::future<int>(int, int)> run = [&run](int iterations,
+                                                        int acc) {
+    if (iterations == 0)
+      return pc::make_ready_future(acc);
+    return pc::async(g_future_tests_env, [] { return 1; })
+        .then([&run, iterations, acc](pc::future<int> f) {
+          return run(iterations - 1, acc + f.get());
+        });
+  };
+  EXPECT_EQ(run(1000, 0).get(), 1000);
+}
+
 } // namespace test
 } // anonymous namespace
 } // namespace portable_concurrency
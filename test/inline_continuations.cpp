@@ -0,0 +1,101 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <portable_concurrency/future>
+
+namespace {
+
+class InlineContinuations : public ::testing::Test {
+protected:
+  InlineContinuations() : depth_{pc::inline_continuations_depth()} {}
+  ~InlineContinuations() { pc::set_inline_continuations_depth(depth_); }
+
+private:
+  unsigned depth_;
+};
+
+TEST_F(InlineContinuations, reports_configured_depth) {
+  pc::set_inline_continuations_depth(8);
+  EXPECT_EQ(pc::inline_continuations_depth(), 8u);
+}
+
+TEST_F(InlineContinuations, deep_chain_is_executed_without_stack_overflow) {
+  constexpr int depth = 200000;
+  auto p = pc::make_promise<int>();
+  pc::future<int> f = std::move(p.second);
+  for (int i = 0; i < depth; ++i)
+    f = f.next([](int val) { return val + 1; });
+  p.first.set_value(0);
+  ASSERT_TRUE(f.is_ready());
+  EXPECT_EQ(f.get(), depth);
+}
+
+TEST_F(InlineContinuations, asynchronous_loop_is_executed_iteratively) {
+  constexpr int iterations = 100000;
+  std::vector<pc::promise<int>> promises;
+  std::vector<pc::future<int>> futures;
+  for (int i = 0; i < iterations; ++i) {
+    auto p = pc::make_promise<int>();
+    promises.push_back(std::move(p.first));
+    futures.push_back(std::move(p.second));
+  }
+  pc::future<int> f = std::move(futures[0]);
+  for (int i = 1; i < iterations; ++i) {
+    f = f.next([&futures, i](int val) {
+      return futures[i].next([val](int inc) { return val + inc; });
+    });
+  }
+  for (auto it = promises.rbegin(); it != promises.rend(); ++it)
+    it->set_value(1);
+  ASSERT_TRUE(f.is_ready());
+  EXPECT_EQ(f.get(), iterations);
+}
+
+TEST_F(InlineContinuations, postponed_continuations_preserve_order) {
+  pc::set_inline_continuations_depth(1);
+  std::vector<int> order;
+  auto p = pc::make_promise<void>();
+  pc::shared_future<void> f = p.second.share();
+  std::vector<pc::future<void>> results;
+  for (int i = 0; i < 3; ++i) {
+    results.push_back(f.next([&order, i] { order.push_back(i); })
+                          .next([&order, i] { order.push_back(10 + i); }));
+  }
+  p.first.set_value();
+  // Continuations of the same state are executed in the reverse order of
+  // their attachment. Postponed continuations are executed in the order they
+  // were postponed once all of the first level continuations are done.
+  EXPECT_EQ(order, (std::vector<int>{2, 1, 0, 12, 11, 10}));
+}
+
+TEST_F(InlineContinuations, continuations_within_depth_are_not_postponed) {
+  pc::set_inline_continuations_depth(2);
+  std::vector<int> order;
+  auto p = pc::make_promise<void>();
+  pc::shared_future<void> f = p.second.share();
+  std::vector<pc::future<void>> results;
+  for (int i = 0; i < 2; ++i) {
+    results.push_back(f.next([&order, i] { order.push_back(i); })
+                          .next([&order, i] { order.push_back(10 + i); }));
+  }
+  p.first.set_value();
+  EXPECT_EQ(order, (std::vector<int>{1, 11, 0, 10}));
+}
+
+TEST_F(InlineContinuations, postponed_continuations_run_before_blocking) {
+  pc::set_inline_continuations_depth(1);
+  auto outer = pc::make_promise<void>();
+  auto inner = pc::make_promise<int>();
+  pc::future<int> inner_result =
+      inner.second.next([](int val) { return val + 1; });
+  pc::future<int> res = outer.second.next([&] {
+    inner.first.set_value(41);
+    // Continuation of the inner promise is postponed at this point
+    return inner_result.get();
+  });
+  outer.first.set_value();
+  EXPECT_EQ(res.get(), 42);
+}
+
+} // anonymous namespace
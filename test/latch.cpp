@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <portable_concurrency/latch>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+TEST(Latch, is_ready_when_counter_reaches_zero) {
+  pc::latch latch{3};
+  EXPECT_FALSE(latch.is_ready());
+  latch.count_down(2);
+  EXPECT_FALSE(latch.is_ready());
+  latch.count_down();
+  EXPECT_TRUE(latch.is_ready());
+}
+
+TEST(Latch, created_with_zero_counter_is_ready) {
+  pc::latch latch{0};
+  EXPECT_TRUE(latch.is_ready());
+  latch.wait();
+}
+
+TEST(Latch, wait_returns_after_all_threads_count_down) {
+  constexpr ptrdiff_t threads_count = 8;
+  constexpr int iterations = 1000;
+  pc::latch latch{threads_count * iterations};
+  std::atomic<int> counter{0};
+  std::vector<std::thread> threads;
+  for (ptrdiff_t i = 0; i < threads_count; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < iterations; ++j) {
+        counter.fetch_add(1, std::memory_order_relaxed);
+        latch.count_down();
+      }
+    });
+  }
+  latch.wait();
+  EXPECT_EQ(counter.load(std::memory_order_relaxed),
+            threads_count * iterations);
+  for (auto &thread : threads)
+    thread.join();
+}
+
+TEST(Latch, can_be_destroyed_right_after_wait_returns) {
+  for (int i = 0; i < 100; ++i) {
+    std::thread thread;
+    {
+      pc::latch latch{2};
+      thread = std::thread{[&latch] { latch.count_down_and_wait(); }};
+      latch.count_down_and_wait();
+    }
+    thread.join();
+  }
+}
+
+} // anonymous namespace
@@ -0,0 +1,131 @@
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <portable_concurrency/functional>
+#include <portable_concurrency/future>
+
+#include "test_tools.h"
+
+namespace {
+namespace test {
+
+class MemoryPool : public ::testing::Test {
+protected:
+  MemoryPool() { pc::set_memory_pool_enabled(true); }
+  ~MemoryPool() { pc::set_memory_pool_enabled(false); }
+
+  template <typename F> std::size_t count_allocations(F &&func) {
+    // First run fills thread cache
+    func();
+    const auto before = allocations_count();
+    func();
+    return allocations_count() - before;
+  }
+};
+
+TEST_F(MemoryPool, reports_enabled_state) {
+  EXPECT_TRUE(pc::memory_pool_enabled());
+  pc::set_memory_pool_enabled(false);
+  EXPECT_FALSE(pc::memory_pool_enabled());
+}
+
+TEST_F(MemoryPool, continuations_chain_does_not_allocate_in_steady_state) {
+  EXPECT_EQ(count_allocations([] {
+              auto p = pc::make_promise<int>();
+              pc::future<int> f = p.second.next([](int val) { return val + 1; })
+                                      .next([](int val) { return 2 * val; });
+              p.first.set_value(1);
+              EXPECT_EQ(f.get(), 4);
+            }),
+            0u);
+}
+
+TEST_F(MemoryPool, continuation_stack_nodes_are_reused) {
+  EXPECT_EQ(count_allocations([] {
+              auto p = pc::make_promise<int>();
+              pc::shared_future<int> f = p.second.share();
+              pc::future<int> f1 = f.next([](int val) { return val + 1; });
+              pc::future<int> f2 = f.next([](int val) { return val + 2; });
+              pc::future<int> f3 = f.next([](int val) { return val + 3; });
+              p.first.set_value(1);
+              EXPECT_EQ(f1.get() + f2.get() + f3.get(), 9);
+            }),
+            0u);
+}
+
+TEST_F(MemoryPool, states_released_by_other_thread_are_reused_by_producer) {
+  constexpr std::size_t states_count = 256;
+  std::vector<pc::future<int>> futures;
+  futures.reserve(states_count);
+  auto produce = [&futures] {
+    for (std::size_t i = 0; i < states_count; ++i) {
+      auto p = pc::make_promise<int>();
+      p.first.set_value(static_cast<int>(i));
+      futures.push_back(std::move(p.second));
+    }
+  };
+  // Last references to the states are released by the consumer thread
+  auto consume = [&futures] {
+    std::thread{[&futures] { futures.clear(); }}.join();
+  };
+
+  produce();
+  consume();
+  const auto before = allocations_count();
+  produce();
+  EXPECT_EQ(allocations_count() - before, 0u);
+  consume();
+}
+
+TEST_F(MemoryPool, big_unique_function_does_not_allocate_in_steady_state) {
+  EXPECT_EQ(count_allocations([] {
+              struct {
+                char data[128];
+              } big = {};
+              pc::unique_function<char()> func = [big] { return big.data[0]; };
+              EXPECT_EQ(func(), 0);
+            }),
+            0u);
+}
+
+#if defined(__cpp_aligned_new)
+struct alignas(64) over_aligned {
+  char data[128];
+};
+
+bool is_aligned(const void *ptr) {
+  return reinterpret_cast<std::uintptr_t>(ptr) % alignof(over_aligned) == 0;
+}
+
+TEST_F(MemoryPool, shared_states_of_over_aligned_values_are_aligned) {
+  std::vector<pc::shared_future<over_aligned>> futures;
+  for (int i = 0; i < 16; ++i) {
+    pc::promise<over_aligned> p;
+    futures.push_back(p.get_future().share());
+    p.set_value(over_aligned{});
+    EXPECT_TRUE(is_aligned(&futures.back().get()));
+  }
+}
+
+TEST_F(MemoryPool, big_over_aligned_functions_are_aligned) {
+  std::vector<pc::unique_function<bool()>> functions;
+  for (int i = 0; i < 16; ++i)
+    functions.emplace_back([val = over_aligned{}] { return is_aligned(&val); });
+  for (auto &func : functions)
+    EXPECT_TRUE(func());
+}
+#endif
+
+TEST_F(MemoryPool, blocks_allocated_by_pool_can_be_released_after_disabling) {
+  auto p = pc::make_promise<std::string>();
+  pc::set_memory_pool_enabled(false);
+  p.first.set_value("Hello");
+  EXPECT_EQ(p.second.get(), "Hello");
+}
+
+} // namespace test
+} // anonymous namespace
@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <chrono>
 #include <map>
+#include <memory>
 #include <thread>
 #include <vector>
 
@@ -73,7 +75,7 @@ TEST(OnceConsumableQueueTests, concurrent_push_until_consume) {
   latch.count_down_and_wait();
   std::this_thread::sleep_for(25ms);
 
-  std::deque<record> records;
+  std::vector<record> records;
   for (const auto &rec : records_stack.consume())
     records.push_back(rec);
 
@@ -94,3 +96,76 @@ TEST(OnceConsumableQueueTests, concurrent_push_until_consume) {
     EXPECT_PRED_FORMAT2(monotonic_sequence, ids_range.first, ids_range.second);
   }
 }
+
+namespace {
+
+template <typename T> struct counting_allocator {
+  using value_type = T;
+
+  explicit counting_allocator(size_t &allocations) noexcept
+      : allocations(&allocations) {}
+  template <typename U>
+  counting_allocator(const counting_allocator<U> &rhs) noexcept
+      : allocations(rhs.allocations) {}
+
+  T *allocate(size_t n) {
+    ++*allocations;
+    return std::allocator<T>{}.allocate(n);
+  }
+  void deallocate(T *p, size_t n) { std::allocator<T>{}.deallocate(p, n); }
+
+  size_t *allocations;
+};
+
+template <typename T, typename U>
+bool operator==(const counting_allocator<T> &lhs,
+                const counting_allocator<U> &rhs) {
+  return lhs.allocations == rhs.allocations;
+}
+
+template <typename T, typename U>
+bool operator!=(const counting_allocator<T> &lhs,
+                const counting_allocator<U> &rhs) {
+  return !(lhs == rhs);
+}
+
+} // namespace
+
+TEST(OnceConsumableQueueTests, first_item_is_pushed_without_allocation) {
+  size_t allocations = 0;
+  counting_allocator<int> alloc{allocations};
+  stack<int> ints;
+
+  int val = 1;
+  EXPECT_TRUE(ints.push(val, alloc));
+  EXPECT_EQ(allocations, 0u);
+  val = 2;
+  EXPECT_TRUE(ints.push(val, alloc));
+  EXPECT_EQ(allocations, 1u);
+}
+
+TEST(OnceConsumableQueueTests, consumed_items_outlive_the_stack) {
+  auto ints = std::make_unique<stack<std::unique_ptr<int>>>();
+  for (int i = 0; i < 3; ++i) {
+    auto val = std::make_unique<int>(i);
+    ASSERT_TRUE(ints->push(val));
+  }
+  auto items = ints->consume();
+  ints.reset();
+
+  std::vector<int> values;
+  for (const auto &item : items)
+    values.push_back(*item);
+  std::sort(values.begin(), values.end());
+  EXPECT_EQ(values, (std::vector<int>{0, 1, 2}));
+}
+
+TEST(OnceConsumableQueueTests, push_to_consumed_stack_leaves_value_intact) {
+  stack<std::unique_ptr<int>> ints;
+  ints.consume();
+
+  auto val = std::make_unique<int>(42);
+  EXPECT_FALSE(ints.push(val));
+  ASSERT_TRUE(val);
+  EXPECT_EQ(*val, 42);
+}
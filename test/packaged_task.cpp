@@ -6,6 +6,7 @@
 
 #include <portable_concurrency/future>
 
+#include "simple_arena_allocator.h"
 #include "test_helpers.h"
 #include "test_tools.h"
 
@@ -126,6 +127,17 @@ TEST(packaged_task, destroys_stored_function_after_invocation) {
   EXPECT_TRUE(wp.expired());
 }
 
+TEST(packaged_task, state_is_allocated_with_provided_allocator) {
+  static_arena<1024> arena;
+  arena_allocator<void, static_arena<1024>> alloc{arena};
+  pc::packaged_task<int(int)> task{std::allocator_arg, alloc,
+                                   [](int val) { return 2 * val; }};
+  EXPECT_GT(arena.used(), 0u);
+  pc::future<int> f = task.get_future();
+  task(21);
+  EXPECT_EQ(f.get(), 42);
+}
+
 // Old tests to refactor
 
 template <typename T> void swap_valid_task_with_invalid() {
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <portable_concurrency/latch>
+#include <portable_concurrency/parallel_algorithm>
+
+#include "test_tools.h"
+
+namespace portable_concurrency {
+namespace {
+namespace test {
+
+struct ParallelAlgorithm : future_test {};
+
+TEST_F(ParallelAlgorithm, for_visits_each_index_once) {
+  std::vector<std::atomic<int>> visits(1000);
+  for (auto &counter : visits)
+    counter = 0;
+  pc::future<void> future =
+      pc::parallel_for(g_future_tests_env, 0u, 1000u, 10,
+                       [&visits](unsigned idx) { ++visits[idx]; });
+  future.get();
+  for (const auto &counter : visits)
+    EXPECT_EQ(counter.load(), 1);
+}
+
+TEST_F(ParallelAlgorithm, for_does_not_split_range_into_chunks_below_grain) {
+  // Chunks posted to inplace_executor are processed right away so any split
+  // breaks the order of the indexes
+  std::vector<int> order;
+  pc::parallel_for(pc::inplace_executor, 0, 11, 10,
+                   [&order](int idx) { order.push_back(idx); })
+      .get();
+  EXPECT_TRUE(std::is_sorted(order.begin(), order.end()));
+  EXPECT_EQ(order.size(), 11u);
+}
+
+TEST_F(ParallelAlgorithm, for_iterates_over_elements_of_iterator_range) {
+  std::vector<int> vals(1000, 1);
+  pc::parallel_for(g_future_tests_env, vals.begin(), vals.end(), 16,
+                   [](int &val) { val *= 2; })
+      .get();
+  EXPECT_TRUE(std::all_of(vals.begin(), vals.end(),
+                          [](int val) { return val == 2; }));
+}
+
+TEST_F(ParallelAlgorithm, for_on_empty_range_gives_ready_future) {
+  pc::future<void> future = pc::parallel_for(
+      g_future_tests_env, 0, 0, 1, [](int) { throw std::runtime_error{"?"}; });
+  EXPECT_TRUE(future.is_ready());
+  EXPECT_NO_THROW(future.get());
+}
+
+TEST_F(ParallelAlgorithm, for_delivers_exception) {
+  pc::future<void> future =
+      pc::parallel_for(g_future_tests_env, 0, 100, 1, [](int idx) {
+        if (idx == 42)
+          throw std::runtime_error{"Ooups"};
+      });
+  EXPECT_RUNTIME_ERROR(future, "Ooups");
+}
+
+TEST_F(ParallelAlgorithm, for_uses_executor_threads) {
+  std::atomic<bool> all_on_executor{true};
+  pc::parallel_for(g_future_tests_env, 0, 100, 1,
+                   [&all_on_executor](int) {
+                     if (!g_future_tests_env->uses_thread(
+                             std::this_thread::get_id()))
+                       all_on_executor = false;
+                   })
+      .get();
+  EXPECT_TRUE(all_on_executor.load());
+}
+
+TEST_F(ParallelAlgorithm, transform_writes_results_in_order) {
+  std::vector<int> src(500);
+  std::iota(src.begin(), src.end(), 0);
+  std::vector<std::string> dst(src.size());
+  pc::future<std::vector<std::string>::iterator> future =
+      pc::parallel_transform(g_future_tests_env, src.begin(), src.end(),
+                             dst.begin(), 8,
+                             [](int val) { return std::to_string(val); });
+  EXPECT_EQ(future.get(), dst.end());
+  for (std::size_t i = 0; i < src.size(); ++i)
+    EXPECT_EQ(dst[i], std::to_string(i));
+}
+
+TEST_F(ParallelAlgorithm, reduce_sums_range) {
+  std::vector<long long> vals(10000);
+  std::iota(vals.begin(), vals.end(), 1);
+  pc::future<long long> future = pc::parallel_reduce(
+      g_future_tests_env, vals.begin(), vals.end(), 100, 0ll);
+  EXPECT_EQ(future.get(), 10000ll * 10001 / 2);
+}
+
+TEST_F(ParallelAlgorithm, reduce_uses_init_and_custom_operation) {
+  pc::future<int> future =
+      pc::parallel_reduce(g_future_tests_env, 1, 10, 2, 1000,
+                          [](int a, int b) { return std::max(a, b); });
+  EXPECT_EQ(future.get(), 1000);
+}
+
+TEST_F(ParallelAlgorithm, reduce_of_empty_range_gives_init) {
+  std::vector<int> vals;
+  pc::future<int> future = pc::parallel_reduce(
+      g_future_tests_env, vals.begin(), vals.end(), 1, 42);
+  EXPECT_EQ(future.get(), 42);
+}
+
+TEST_F(ParallelAlgorithm, sort_orders_range) {
+  std::vector<int> vals(20000);
+  std::mt19937 gen{42};
+  std::uniform_int_distribution<int> dist{0, 1000};
+  std::generate(vals.begin(), vals.end(), [&] { return dist(gen); });
+  pc::parallel_sort(g_future_tests_env, vals.begin(), vals.end(), 256).get();
+  EXPECT_TRUE(std::is_sorted(vals.begin(), vals.end()));
+}
+
+TEST_F(ParallelAlgorithm, sort_uses_custom_comparator) {
+  std::vector<int> vals(5000);
+  std::iota(vals.begin(), vals.end(), 0);
+  std::shuffle(vals.begin(), vals.end(), std::mt19937{7});
+  pc::parallel_sort(g_future_tests_env, vals.begin(), vals.end(), 64,
+                    std::greater<>{})
+      .get();
+  EXPECT_TRUE(std::is_sorted(vals.begin(), vals.end(), std::greater<>{}));
+}
+
+TEST_F(ParallelAlgorithm, sort_handles_equal_elements) {
+  std::vector<int> vals(3000, 7);
+  vals[1500] = 3;
+  pc::parallel_sort(g_future_tests_env, vals.begin(), vals.end(), 16).get();
+  EXPECT_EQ(vals.front(), 3);
+  EXPECT_TRUE(std::is_sorted(vals.begin(), vals.end()));
+}
+
+TEST(ParallelAlgorithmOnThreadPool, abandoned_chunks_break_promise) {
+  pc::latch latch_before_stop{2};
+  pc::latch latch_after_stop{2};
+  pc::future<void> future;
+  {
+    pc::static_thread_pool pool{1};
+
+    post(pool.executor(), [&latch_before_stop, &latch_after_stop] {
+      latch_before_stop.count_down_and_wait();
+      latch_after_stop.count_down_and_wait();
+    });
+    future = pc::parallel_for(pool.executor(), 0, 100, 1, [](int) {});
+
+    latch_before_stop.count_down_and_wait();
+    pool.stop();
+    latch_after_stop.count_down_and_wait();
+  }
+
+  EXPECT_FUTURE_ERROR(future.get(), std::future_errc::broken_promise);
+}
+
+} // namespace test
+} // namespace
+} // namespace portable_concurrency
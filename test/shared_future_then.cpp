@@ -6,6 +6,7 @@
 
 #include <portable_concurrency/future>
 
+#include "simple_arena_allocator.h"
 #include "test_helpers.h"
 #include "test_tools.h"
 
@@ -194,6 +195,35 @@ TEST_F(SharedFutureThen, desroys_continuation_after_invocation) {
   EXPECT_TRUE(wp.expired());
 }
 
+TEST_F(SharedFutureThen, continuations_are_allocated_with_provided_allocator) {
+  static_arena<1024> arena;
+  arena_allocator<void, static_arena<1024>> alloc{arena};
+  pc::future<std::string> f1 =
+      future.then(std::allocator_arg, alloc, stringify);
+  const auto used = arena.used();
+  EXPECT_GT(used, 0u);
+  pc::future<int> f2 =
+      future.next(std::allocator_arg, alloc, [](int val) { return val + 1; });
+  EXPECT_GT(arena.used(), used);
+  promise.set_value(42);
+  EXPECT_EQ(f1.get(), "42");
+  EXPECT_EQ(f2.get(), 43);
+}
+
+TEST_F(SharedFutureThen,
+       interruptible_continuation_state_is_allocated_with_allocator) {
+  static_arena<1024> arena;
+  arena_allocator<void, static_arena<1024>> alloc{arena};
+  pc::future<int> cnt_f =
+      future.then(std::allocator_arg, alloc,
+                  [](pc::promise<int> p, pc::shared_future<int> f) {
+                    p.set_value(f.get() + 1);
+                  });
+  EXPECT_GT(arena.used(), 0u);
+  promise.set_value(41);
+  EXPECT_EQ(cnt_f.get(), 42);
+}
+
 } // namespace test
 } // anonymous namespace
 } // namespace portable_concurrency
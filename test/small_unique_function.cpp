@@ -1,5 +1,6 @@
 #include <array>
 #include <cstring>
+#include <memory>
 #include <string>
 
 #include <gtest/gtest.h>
@@ -80,5 +81,43 @@ TEST_F(small_unique_function, const_object_can_be_invoked) {
   EXPECT_EQ(f(2), 2);
 }
 
+TEST_F(small_unique_function, custom_buffer_size) {
+  std::array<char, 64> data = {{'a', 'b', 'c'}};
+  pc::detail::small_unique_function<char(size_t), sizeof(data)> f0 =
+      [data](size_t idx) { return data[idx]; };
+  auto f1 = std::move(f0);
+  EXPECT_EQ(f1(2), 'c');
+}
+
+TEST_F(small_unique_function, trivially_copyable_callable_is_relocated) {
+  int val = 42;
+  auto lambda = [ptr = &val, mul = 2] { return *ptr * mul; };
+  using vtbl_t = pc::detail::callable_vtbl<int>;
+  const vtbl_t &vtbl = pc::detail::get_callable_vtbl<decltype(lambda), int>();
+  EXPECT_EQ(vtbl.move, nullptr);
+  EXPECT_EQ(vtbl.destroy, nullptr);
+
+  pc::detail::small_unique_function<int()> f0 = lambda;
+  pc::detail::small_unique_function<int()> f1 = std::move(f0);
+  pc::detail::small_unique_function<int()> f2;
+  f2 = std::move(f1);
+  EXPECT_EQ(f2(), 84);
+}
+
+TEST_F(small_unique_function, non_trivial_callable_is_moved_and_destroyed) {
+  auto sp = std::make_shared<int>(42);
+  std::weak_ptr<int> wp = sp;
+  {
+    pc::detail::small_unique_function<int()> f0 =
+        [sp = std::exchange(sp, nullptr)] { return *sp; };
+    pc::detail::small_unique_function<int()> f1 = std::move(f0);
+    pc::detail::small_unique_function<int()> f2;
+    f2 = std::move(f1);
+    EXPECT_EQ(f2(), 42);
+    EXPECT_EQ(wp.use_count(), 1);
+  }
+  EXPECT_TRUE(wp.expired());
+}
+
 } // namespace test
 } // anonymous namespace
@@ -1,7 +1,27 @@
+#include <cstdlib>
+#include <new>
+
 #include <portable_concurrency/latch>
 
 #include "test_tools.h"
 
+namespace {
+thread_local std::size_t allocations = 0;
+} // anonymous namespace
+
+void *operator new(std::size_t size) {
+  ++allocations;
+  if (void *res = std::malloc(size == 0 ? 1 : size))
+    return res;
+  throw std::bad_alloc{};
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+std::size_t allocations_count() { return allocations; }
+
 future_tests_env *g_future_tests_env = static_cast<future_tests_env *>(
     ::testing::AddGlobalTestEnvironment(new future_tests_env{
         std::max(3u, std::thread::hardware_concurrency())}));
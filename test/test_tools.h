@@ -108,3 +108,6 @@ void expect_future_exception(const pc::shared_future<void> &future,
                              const std::string &what);
 
 #define EXPECT_RUNTIME_ERROR(future, what) expect_future_exception(future, what)
+
+// Number of global operator new calls made by the current thread so far
+std::size_t allocations_count();
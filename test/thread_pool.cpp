@@ -1,18 +1,96 @@
 #include <gtest/gtest.h>
 
+#include <portable_concurrency/future>
 #include <portable_concurrency/latch>
 #include <portable_concurrency/thread_pool>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <functional>
+#include <numeric>
+#include <future>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
 
 namespace {
 
-TEST(ThreadPool, should_execute_function_in_another_thread) {
+struct ThreadPool : ::testing::TestWithParam<pc::thread_pool_scheduling> {
+  pc::thread_pool_options options() const {
+    pc::thread_pool_options res;
+    res.scheduling = GetParam();
+    return res;
+  }
+};
+
+// Task 1 posts task 2 from the worker thread while task 3 is already queued.
+// Returns the order the tasks are executed in.
+std::vector<int> posted_from_worker_order(const pc::thread_pool_options &opts) {
+  std::vector<int> order;
+  pc::latch start{2};
+  pc::latch done{3};
+  pc::static_thread_pool pool{1, opts};
+  auto exec = pool.executor();
+
+  // Block the only worker until all of the tasks are queued
+  post(exec, [&start] { start.count_down_and_wait(); });
+  post(exec, [&order, &done, exec] {
+    order.push_back(1);
+    post(exec, [&order, &done] {
+      order.push_back(2);
+      done.count_down();
+    });
+    done.count_down();
+  });
+  post(exec, [&order, &done] {
+    order.push_back(3);
+    done.count_down();
+  });
+  start.count_down_and_wait();
+  done.wait();
+  return order;
+}
+
+// Task posted from the worker which then stays busy without blocking for
+// `busy_for` or until the posted task is executed. Checks if the posted task
+// is executed by another worker.
+bool taken_from_busy_worker(const pc::thread_pool_options &opts,
+                            std::chrono::milliseconds busy_for) {
+  std::atomic<bool> executed{false};
+  std::thread::id owner;
+  std::thread::id executor;
+  pc::latch done{2};
+  pc::static_thread_pool pool{2, opts};
+  auto exec = pool.executor();
+
+  post(exec, [&] {
+    owner = std::this_thread::get_id();
+    post(exec, [&] {
+      executor = std::this_thread::get_id();
+      executed = true;
+      done.count_down();
+    });
+    const auto deadline = std::chrono::steady_clock::now() + busy_for;
+    while (!executed && std::chrono::steady_clock::now() < deadline)
+      std::this_thread::yield();
+    done.count_down();
+  });
+  done.wait();
+  return executor != owner;
+}
+
+TEST_P(ThreadPool, should_execute_function_in_another_thread) {
   std::thread::id tid;
   std::mutex mtx;
   std::condition_variable cv;
 
-  pc::static_thread_pool pool{1};
+  pc::static_thread_pool pool{1, options()};
   post(pool.executor(), [&] {
     {
       std::lock_guard<std::mutex> lk{mtx};
@@ -25,10 +103,10 @@ TEST(ThreadPool, should_execute_function_in_another_thread) {
   EXPECT_NE(tid, std::this_thread::get_id());
 }
 
-TEST(ThreadPool, processes_all_queued_tasks_when_waited_on) {
+TEST_P(ThreadPool, processes_all_queued_tasks_when_waited_on) {
   static constexpr size_t task_count = 1;
 
-  pc::static_thread_pool pool{1};
+  pc::static_thread_pool pool{1, options()};
 
   std::atomic<size_t> processed_tasks_count{0};
   pc::latch latch{2};
@@ -49,10 +127,10 @@ TEST(ThreadPool, processes_all_queued_tasks_when_waited_on) {
   EXPECT_EQ(processed_tasks_count.load(), task_count);
 }
 
-TEST(ThreadPool, abandons_unprocessed_tasks_when_stopped) {
+TEST_P(ThreadPool, abandons_unprocessed_tasks_when_stopped) {
   static constexpr size_t task_count = 1;
 
-  pc::static_thread_pool pool{1};
+  pc::static_thread_pool pool{1, options()};
 
   std::atomic<size_t> processed_tasks_count{0};
   pc::latch latch_before_stop{2};
@@ -77,4 +155,545 @@ TEST(ThreadPool, abandons_unprocessed_tasks_when_stopped) {
   EXPECT_EQ(processed_tasks_count.load(), 0);
 }
 
+TEST_P(ThreadPool, abandoned_tasks_break_promises) {
+  pc::latch latch_before_stop{2};
+  pc::latch latch_after_stop{2};
+  pc::future<int> future;
+  {
+    pc::static_thread_pool pool{1, options()};
+
+    post(pool.executor(), [&latch_before_stop, &latch_after_stop] {
+      latch_before_stop.count_down_and_wait();
+      latch_after_stop.count_down_and_wait();
+    });
+    future = pc::async(pool.executor(), [] { return 42; });
+
+    latch_before_stop.count_down_and_wait();
+    pool.stop();
+    latch_after_stop.count_down_and_wait();
+  }
+
+  EXPECT_THROW(future.get(), std::future_error);
+}
+
+TEST_P(ThreadPool, tasks_posted_concurrently_with_close_are_not_left_queued) {
+  pc::static_thread_pool pool{2, options()};
+  std::vector<pc::future<int>> futures;
+  std::atomic<bool> started{false};
+  std::atomic<bool> closing{false};
+  std::thread poster{[&] {
+    while (!closing.load()) {
+      futures.push_back(pc::async(pool.executor(), [] { return 42; }));
+      started = true;
+    }
+    for (int i = 0; i < 1000; ++i)
+      futures.push_back(pc::async(pool.executor(), [] { return 42; }));
+  }};
+  while (!started.load())
+    std::this_thread::yield();
+  closing = true;
+  pool.wait();
+  poster.join();
+
+  for (const auto &future : futures)
+    EXPECT_TRUE(future.is_ready());
+}
+
+TEST_P(ThreadPool, processes_tasks_posted_from_worker_threads) {
+  static constexpr size_t task_count = 1000;
+
+  std::atomic<size_t> processed_tasks_count{0};
+  pc::latch latch{task_count};
+  pc::static_thread_pool pool{3, options()};
+
+  post(pool.executor(), [&] {
+    for (size_t i = 0; i < task_count; ++i) {
+      post(pool.executor(), [&] {
+        ++processed_tasks_count;
+        latch.count_down();
+      });
+    }
+  });
+
+  latch.wait();
+  EXPECT_EQ(processed_tasks_count.load(), task_count);
+}
+
+TEST_P(ThreadPool, idle_workers_pick_up_tasks_posted_by_a_blocked_worker) {
+  pc::static_thread_pool pool{2, options()};
+
+  pc::future<int> res = pc::async(pool.executor(), [&pool] {
+    // The nested task can only be processed by the other worker
+    return pc::async(pool.executor(), [] { return 42; }).get();
+  });
+
+  EXPECT_EQ(res.get(), 42);
+}
+
+TEST_P(ThreadPool, all_workers_are_used) {
+  static constexpr size_t threads_count = 4;
+
+  std::mutex mtx;
+  std::set<std::thread::id> tids;
+  pc::latch latch{threads_count + 1};
+  pc::static_thread_pool pool{threads_count, options()};
+
+  for (size_t i = 0; i < threads_count; ++i) {
+    post(pool.executor(), [&] {
+      {
+        std::lock_guard<std::mutex> lock{mtx};
+        tids.insert(std::this_thread::get_id());
+      }
+      latch.count_down_and_wait();
+    });
+  }
+
+  latch.count_down_and_wait();
+  EXPECT_EQ(tids.size(), threads_count);
+}
+
+TEST_P(ThreadPool, attached_thread_processes_tasks) {
+  pc::static_thread_pool pool{0, options()};
+  std::thread::id tid;
+
+  post(pool.executor(), [&] {
+    tid = std::this_thread::get_id();
+    pool.stop();
+  });
+  pool.attach();
+
+  EXPECT_EQ(tid, std::this_thread::get_id());
+}
+
+TEST_P(ThreadPool, task_posted_from_worker_is_executed_next) {
+  EXPECT_EQ(posted_from_worker_order(options()), (std::vector<int>{1, 2, 3}));
+}
+
+TEST_P(ThreadPool, task_posted_from_busy_worker_is_taken_by_idle_one) {
+  EXPECT_TRUE(taken_from_busy_worker(options(), std::chrono::seconds{5}));
+}
+
+TEST_P(ThreadPool, continuations_chain_does_not_starve_queued_tasks) {
+  constexpr unsigned budget = 4;
+  constexpr int chain_length = 100;
+  std::vector<int> order;
+  std::function<void(int)> chain_step;
+  pc::latch start{2};
+  pc::latch done{chain_length + 2};
+  auto opts = options();
+  opts.lifo_slot_budget = budget;
+  pc::static_thread_pool pool{1, opts};
+  auto exec = pool.executor();
+
+  chain_step = [&](int remains) {
+    order.push_back(0);
+    if (remains > 0)
+      post(exec, [&chain_step, remains] { chain_step(remains - 1); });
+    done.count_down();
+  };
+  post(exec, [&start] { start.count_down_and_wait(); });
+  post(exec, [&chain_step] { chain_step(chain_length); });
+  post(exec, [&order, &done] {
+    order.push_back(1);
+    done.count_down();
+  });
+  start.count_down_and_wait();
+  done.wait();
+
+  EXPECT_EQ(std::find(order.begin(), order.end(), 1) - order.begin(),
+            budget + 1);
+}
+
+TEST_P(ThreadPool, ping_pong_with_external_thread) {
+  static constexpr int round_trips = 1000;
+
+  pc::static_thread_pool pool{2, options()};
+  for (int i = 0; i < round_trips; ++i) {
+    pc::future<int> res = pc::async(pool.executor(), [i] { return i + 1; });
+    ASSERT_EQ(res.get(), i + 1);
+  }
+}
+
+TEST_P(ThreadPool, workers_park_without_spinning) {
+  static constexpr size_t task_count = 100;
+
+  auto opts = options();
+  opts.idle_spin_count = 0;
+  opts.idle_yield_count = 0;
+  std::atomic<size_t> processed_tasks_count{0};
+  pc::latch latch{task_count};
+  pc::static_thread_pool pool{2, opts};
+
+  for (size_t i = 0; i < task_count; ++i) {
+    post(pool.executor(), [&] {
+      ++processed_tasks_count;
+      latch.count_down();
+    });
+  }
+
+  latch.wait();
+  EXPECT_EQ(processed_tasks_count.load(), task_count);
+}
+
+TEST_P(ThreadPool, processes_bulk_posted_tasks) {
+  static constexpr size_t task_count = 100;
+
+  std::atomic<size_t> processed_tasks_count{0};
+  pc::latch latch{task_count};
+  pc::static_thread_pool pool{3, options()};
+
+  std::vector<pc::unique_function<void()>> tasks;
+  for (size_t i = 0; i < task_count; ++i) {
+    tasks.emplace_back([&] {
+      ++processed_tasks_count;
+      latch.count_down();
+    });
+  }
+  post_bulk(pool.executor(), tasks.begin(), tasks.end());
+
+  latch.wait();
+  EXPECT_EQ(processed_tasks_count.load(), task_count);
+}
+
+TEST_P(ThreadPool, bulk_posted_tasks_wake_up_all_workers) {
+  static constexpr size_t threads_count = 4;
+
+  std::mutex mtx;
+  std::set<std::thread::id> tids;
+  pc::latch latch{threads_count + 1};
+  pc::static_thread_pool pool{threads_count, options()};
+
+  pc::future<void> res =
+      pc::bulk_async(pool.executor(), threads_count, [&](size_t) {
+        {
+          std::lock_guard<std::mutex> lock{mtx};
+          tids.insert(std::this_thread::get_id());
+        }
+        latch.count_down_and_wait();
+      });
+
+  latch.count_down_and_wait();
+  res.get();
+  EXPECT_EQ(tids.size(), threads_count);
+}
+
+TEST_P(ThreadPool, bulk_posted_tasks_from_worker_thread_are_processed) {
+  pc::static_thread_pool pool{2, options()};
+
+  pc::future<int> res = pc::async(pool.executor(), [&pool] {
+    pc::future<std::vector<int>> nested = pc::bulk_async(
+        pool.executor(), 10, [](size_t i) { return static_cast<int>(i); });
+    return nested.next([](std::vector<int> vals) {
+      return std::accumulate(vals.begin(), vals.end(), 0);
+    });
+  });
+
+  EXPECT_EQ(res.get(), 45);
+}
+
+TEST_P(ThreadPool, abandoned_bulk_tasks_break_promise) {
+  pc::latch latch_before_stop{2};
+  pc::latch latch_after_stop{2};
+  pc::future<std::vector<int>> future;
+  {
+    pc::static_thread_pool pool{1, options()};
+
+    post(pool.executor(), [&latch_before_stop, &latch_after_stop] {
+      latch_before_stop.count_down_and_wait();
+      latch_after_stop.count_down_and_wait();
+    });
+    future = pc::bulk_async(pool.executor(), 10,
+                            [](size_t i) { return static_cast<int>(i); });
+
+    latch_before_stop.count_down_and_wait();
+    pool.stop();
+    latch_after_stop.count_down_and_wait();
+  }
+
+  EXPECT_THROW(future.get(), std::future_error);
+}
+
+TEST_P(ThreadPool, worker_executor_runs_tasks_on_the_same_worker) {
+  static constexpr size_t task_count = 32;
+
+  std::mutex mtx;
+  std::set<std::thread::id> tids;
+  pc::latch done{task_count};
+  pc::static_thread_pool pool{4, options()};
+  auto exec = pool.worker_executor(2);
+
+  for (size_t i = 0; i < task_count; ++i) {
+    post(exec, [&] {
+      {
+        std::lock_guard<std::mutex> lock{mtx};
+        tids.insert(std::this_thread::get_id());
+      }
+      done.count_down();
+    });
+  }
+  done.wait();
+
+  EXPECT_EQ(tids.size(), 1u);
+}
+
+TEST_P(ThreadPool, node_executor_runs_tasks_on_workers_of_the_node) {
+  static constexpr size_t task_count = 32;
+
+  std::mutex mtx;
+  std::set<std::thread::id> node_tids;
+  std::set<std::thread::id> tids;
+  pc::latch start{5};
+  pc::latch done{task_count};
+  auto opts = options();
+  opts.worker_nodes = {0, 1};
+  pc::static_thread_pool pool{4, opts};
+
+  // Workers 1 and 3 belong to the node 1
+  for (size_t worker = 0; worker < 4; ++worker) {
+    post(pool.worker_executor(worker), [&, worker] {
+      if (worker % 2 == 1) {
+        std::lock_guard<std::mutex> lock{mtx};
+        node_tids.insert(std::this_thread::get_id());
+      }
+      start.count_down_and_wait();
+    });
+  }
+  start.count_down_and_wait();
+
+  for (size_t i = 0; i < task_count; ++i) {
+    post(pool.node_executor(1), [&] {
+      {
+        std::lock_guard<std::mutex> lock{mtx};
+        tids.insert(std::this_thread::get_id());
+      }
+      done.count_down();
+    });
+  }
+  done.wait();
+
+  EXPECT_TRUE(std::includes(node_tids.begin(), node_tids.end(), tids.begin(),
+                            tids.end()));
+}
+
+TEST_P(ThreadPool, targeted_executors_reject_unknown_targets) {
+  auto opts = options();
+  opts.worker_nodes = {0, 2};
+  pc::static_thread_pool pool{2, opts};
+
+  EXPECT_NO_THROW(pool.worker_executor(1));
+  EXPECT_THROW(pool.worker_executor(2), std::out_of_range);
+  EXPECT_NO_THROW(pool.node_executor(2));
+  EXPECT_THROW(pool.node_executor(1), std::out_of_range);
+  EXPECT_THROW(pool.node_executor(3), std::out_of_range);
+}
+
+TEST_P(ThreadPool, pinned_workers_process_tasks) {
+  auto opts = options();
+#if defined(__linux__)
+  const int cpu = sched_getcpu();
+  ASSERT_GE(cpu, 0);
+  opts.worker_cpus = {{static_cast<unsigned>(cpu)}};
+#else
+  opts.worker_cpus = {{0}};
+#endif
+  pc::static_thread_pool pool{2, opts};
+
+#if defined(__linux__)
+  EXPECT_EQ(pc::async(pool.executor(), [] { return sched_getcpu(); }).get(),
+            cpu);
+#else
+  EXPECT_EQ(pc::async(pool.executor(), [] { return 42; }).get(), 42);
+#endif
+}
+
+TEST_P(ThreadPool, pool_with_numa_options_processes_tasks) {
+  pc::static_thread_pool pool{2, pc::numa_thread_pool_options(options())};
+
+  EXPECT_EQ(pc::async(pool.node_executor(0), [] { return 42; }).get(), 42);
+}
+
+TEST_P(ThreadPool, high_priority_tasks_are_processed_first) {
+  std::vector<pc::priority> order;
+  pc::latch start{2};
+  pc::latch done{4};
+  auto opts = options();
+  opts.starvation_check_period = 0;
+  pc::static_thread_pool pool{1, opts};
+
+  post(pool.executor(), [&start] { start.count_down_and_wait(); });
+  for (auto prio :
+       {pc::priority::low, pc::priority::normal, pc::priority::high}) {
+    post(pool.executor(prio), [&order, &done, prio] {
+      order.push_back(prio);
+      done.count_down();
+    });
+  }
+  start.count_down_and_wait();
+  done.count_down_and_wait();
+
+  EXPECT_EQ(order, (std::vector<pc::priority>{
+                       pc::priority::high, pc::priority::normal,
+                       pc::priority::low}));
+}
+
+TEST_P(ThreadPool, low_priority_tasks_are_not_starved) {
+  static constexpr size_t high_count = 16;
+
+  std::vector<pc::priority> order;
+  pc::latch start{2};
+  pc::latch done{high_count + 2};
+  auto opts = options();
+  opts.starvation_check_period = 4;
+  pc::static_thread_pool pool{1, opts};
+
+  post(pool.executor(), [&start] { start.count_down_and_wait(); });
+  post(pool.executor(pc::priority::low), [&order, &done] {
+    order.push_back(pc::priority::low);
+    done.count_down();
+  });
+  for (size_t i = 0; i < high_count; ++i) {
+    post(pool.executor(pc::priority::high), [&order, &done] {
+      order.push_back(pc::priority::high);
+      done.count_down();
+    });
+  }
+  start.count_down_and_wait();
+  done.count_down_and_wait();
+
+  ASSERT_EQ(order.size(), high_count + 1);
+  EXPECT_NE(order.back(), pc::priority::low);
+}
+
+TEST_P(ThreadPool, prioritized_executor_runs_continuations) {
+  pc::static_thread_pool pool{2, options()};
+  auto high = pool.executor(pc::priority::high);
+  auto low = pool.executor(pc::priority::low);
+
+  pc::future<int> res = pc::async(high, [] { return 20; })
+                            .then(low, [](pc::future<int> f) {
+                              return f.get() + 1;
+                            })
+                            .next(high, [](int val) { return val * 2; });
+
+  EXPECT_EQ(res.get(), 42);
+}
+
+TEST_P(ThreadPool, bulk_posted_prioritized_tasks_are_processed) {
+  static constexpr size_t task_count = 64;
+
+  std::atomic<size_t> executed{0};
+  pc::static_thread_pool pool{2, options()};
+  for (auto prio : {pc::priority::low, pc::priority::high}) {
+    std::vector<pc::unique_function<void()>> tasks;
+    for (size_t i = 0; i < task_count; ++i)
+      tasks.emplace_back([&executed] { ++executed; });
+    post_bulk(pool.executor(prio), tasks.begin(), tasks.end());
+  }
+  pool.wait();
+
+  EXPECT_EQ(executed.load(), 2 * task_count);
+}
+
+TEST_P(ThreadPool, stats_count_executed_tasks) {
+  static constexpr size_t task_count = 32;
+
+  auto opts = options();
+  opts.collect_stats = true;
+  pc::static_thread_pool pool{2, opts};
+  for (size_t i = 0; i < task_count; ++i)
+    post(pool.executor(), [] {});
+  pool.wait();
+
+  const pc::thread_pool_stats stats = pool.stats();
+  ASSERT_EQ(stats.workers.size(), 2u);
+  EXPECT_EQ(stats.queued_tasks, 0u);
+  EXPECT_EQ(std::accumulate(stats.workers.begin(), stats.workers.end(),
+                            uint64_t{0},
+                            [](uint64_t sum, const auto &worker) {
+                              return sum + worker.tasks_executed;
+                            }),
+            task_count);
+  EXPECT_EQ(stats.queue_latency.count(), task_count);
+  EXPECT_EQ(stats.execution_time.count(), task_count);
+}
+
+TEST_P(ThreadPool, stats_measure_busy_time) {
+  auto opts = options();
+  opts.collect_stats = true;
+  pc::static_thread_pool pool{1, opts};
+  post(pool.executor(),
+       [] { std::this_thread::sleep_for(std::chrono::milliseconds{5}); });
+  pool.wait();
+
+  const pc::thread_pool_stats stats = pool.stats();
+  ASSERT_EQ(stats.workers.size(), 1u);
+  EXPECT_GE(stats.workers[0].busy_time, std::chrono::milliseconds{5});
+  // Bucket 22 holds durations starting from 2^22ns ~ 4.2ms
+  EXPECT_EQ(std::accumulate(stats.execution_time.buckets.begin() + 22,
+                            stats.execution_time.buckets.end(), uint64_t{0}),
+            1u);
+}
+
+TEST_P(ThreadPool, stats_report_queued_tasks) {
+  pc::latch start{2};
+  pc::latch release{2};
+  pc::static_thread_pool pool{1, options()};
+  post(pool.executor(), [&] {
+    start.count_down();
+    release.count_down_and_wait();
+  });
+  start.count_down_and_wait();
+  for (int i = 0; i < 3; ++i)
+    post(pool.executor(), [] {});
+
+  EXPECT_EQ(pool.stats().queued_tasks, 3u);
+  release.count_down_and_wait();
+}
+
+TEST_P(ThreadPool, task_hooks_are_called_on_worker_thread) {
+  std::atomic<size_t> begins{0};
+  std::atomic<size_t> ends{0};
+  auto opts = options();
+  opts.on_task_begin = [&](size_t worker) {
+    EXPECT_EQ(worker, 0u);
+    EXPECT_EQ(begins.load(), ends.load());
+    ++begins;
+  };
+  opts.on_task_end = [&](size_t worker) {
+    EXPECT_EQ(worker, 0u);
+    ++ends;
+  };
+  pc::static_thread_pool pool{1, opts};
+
+  EXPECT_EQ(pc::async(pool.executor(), [&] { return begins.load(); }).get(),
+            1u);
+  pool.wait();
+  EXPECT_EQ(begins.load(), 1u);
+  EXPECT_EQ(ends.load(), 1u);
+}
+
+TEST(ThreadPoolLifoSlot, can_be_disabled) {
+  pc::thread_pool_options opts;
+  opts.scheduling = pc::thread_pool_scheduling::work_stealing;
+  opts.lifo_slot_steal_delay = std::chrono::hours{1};
+  EXPECT_FALSE(taken_from_busy_worker(opts, std::chrono::milliseconds{20}));
+
+  // Task goes to the worker deque where idle workers steal it from right away
+  opts.lifo_slot_budget = 0;
+  EXPECT_TRUE(taken_from_busy_worker(opts, std::chrono::seconds{5}));
+}
+
+TEST(ThreadPoolLifoSlot, disabled_keeps_order_of_shared_queue) {
+  pc::thread_pool_options opts;
+  opts.scheduling = pc::thread_pool_scheduling::shared_queue;
+  opts.lifo_slot_budget = 0;
+  EXPECT_EQ(posted_from_worker_order(opts), (std::vector<int>{1, 3, 2}));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Scheduling, ThreadPool,
+    ::testing::Values(pc::thread_pool_scheduling::shared_queue,
+                      pc::thread_pool_scheduling::work_stealing,
+                      pc::thread_pool_scheduling::lock_free_queue));
+
 } // namespace
@@ -1,3 +1,6 @@
+#include <chrono>
+#include <thread>
+
 #include <gtest/gtest.h>
 
 #include <portable_concurrency/future>
@@ -86,6 +89,43 @@ TYPED_TEST(timed_waiter_on_ready, wait_for_returns_ready) {
   EXPECT_EQ(this->waiter.wait_for(2h), pc::future_status::ready);
 }
 
+TEST(timed_waiter_abandoned, wait_for_returns_timeout_if_future_destroyed) {
+  pc::promise<int> promise;
+  pc::timed_waiter waiter;
+  {
+    pc::future<int> future = promise.get_future();
+    waiter = pc::timed_waiter{future};
+  }
+  EXPECT_EQ(waiter.wait_for(5ms), pc::future_status::timeout);
+}
+
+TEST(timed_waiter_allocations, construction_and_waiting_do_not_allocate) {
+  auto p = pc::make_promise<int>();
+  pc::future<int> f = std::move(p.second);
+  std::thread producer{[promise = std::move(p.first)]() mutable {
+    std::this_thread::sleep_for(std::chrono::milliseconds{5});
+    promise.set_value(42);
+  }};
+  const auto before = allocations_count();
+  pc::timed_waiter waiter{f};
+  EXPECT_EQ(waiter.wait_for(std::chrono::microseconds{1}),
+            pc::future_status::timeout);
+  EXPECT_EQ(waiter.wait_for(std::chrono::seconds{5}), pc::future_status::ready);
+  EXPECT_EQ(allocations_count() - before, 0u);
+  producer.join();
+  EXPECT_EQ(f.get(), 42);
+}
+
+TEST(timed_waiter_allocations, ready_future_waiter_does_not_allocate) {
+  pc::future<int> f = pc::make_ready_future(42);
+  const auto before = allocations_count();
+  pc::timed_waiter waiter{f};
+  EXPECT_EQ(waiter.wait_for(std::chrono::microseconds{1}),
+            pc::future_status::ready);
+  EXPECT_EQ(allocations_count() - before, 0u);
+  EXPECT_EQ(f.get(), 42);
+}
+
 } // namespace test
 } // anonymous namespace
 } // namespace portable_concurrency
@@ -6,6 +6,13 @@
 
 #include <portable_concurrency/functional>
 
+// User code is allowed to forward declare unique_function class template
+namespace portable_concurrency {
+inline namespace cxx14_v1 {
+template <typename S> class unique_function;
+} // namespace cxx14_v1
+} // namespace portable_concurrency
+
 namespace {
 
 namespace test {
@@ -231,6 +238,40 @@ TEST(UniqueFunction, call_small_non_copyable_function_after_move_asign) {
   EXPECT_EQ(f1(42), 84);
 }
 
+TEST(UniqueFunction, custom_buffer_stores_big_functor_inline) {
+  using func_t = pc::basic_unique_function<uint64_t(uint64_t), sizeof(big)>;
+  static_assert(pc::detail::is_storable_t<big, sizeof(big)>::value, "");
+  func_t f0 = [c = big{1, 2, 3, 4, 5, 6}](uint64_t x) {
+    return x + c.u0 + c.u1 + c.u2 + c.u3 + c.u4 + c.u5;
+  };
+  func_t f1;
+  f1 = std::move(f0);
+  EXPECT_TRUE(f1);
+  EXPECT_EQ(f1(42), 63u);
+}
+
+TEST(UniqueFunction, is_basic_unique_function_with_default_buffer) {
+  using func_t = pc::unique_function<int(int)>;
+  static_assert(
+      std::is_base_of<pc::basic_unique_function<int(int)>, func_t>::value,
+      "");
+  static_assert(std::is_nothrow_default_constructible<func_t>::value, "");
+  static_assert(!std::is_copy_constructible<func_t>::value, "");
+  static_assert(!std::is_constructible<func_t, func_t &>::value, "");
+  func_t f0 = [](int x) { return 2 * x; };
+  pc::basic_unique_function<int(int)> f1 = std::move(f0);
+  EXPECT_EQ(f1(21), 42);
+}
+
+TEST(UniqueFunction, custom_buffer_stores_bigger_functor_on_heap) {
+  pc::basic_unique_function<uint64_t(uint64_t), sizeof(void *)> f0 =
+      [c = big{1, 2, 3, 4, 5, 6}](uint64_t x) {
+        return x + c.u0 + c.u1 + c.u2 + c.u3 + c.u4 + c.u5;
+      };
+  auto f1 = std::move(f0);
+  EXPECT_EQ(f1(42), 63u);
+}
+
 TEST(UniqueFunction, pass_builtin_type_argument) {
   pc::unique_function<int(int)> f = [](int x) { return 2 * x; };
   EXPECT_EQ(f(21), 42);
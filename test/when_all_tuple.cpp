@@ -3,6 +3,7 @@
 #include <portable_concurrency/future>
 #include <portable_concurrency/latch>
 
+#include "simple_arena_allocator.h"
 #include "test_tools.h"
 
 using namespace std::literals;
@@ -238,4 +239,22 @@ TEST(WhenAllTupleTest, all_initially_redy) {
   ASSERT_NO_THROW(std::get<2>(res).get());
 }
 
+TEST(WhenAllTupleTest, state_is_allocated_with_provided_allocator) {
+  static_arena<1024> arena;
+  arena_allocator<void, static_arena<1024>> alloc{arena};
+  auto p1 = pc::make_promise<int>();
+  auto p2 = pc::make_promise<std::string>();
+  auto f = pc::when_all(std::allocator_arg, alloc, std::move(p1.second),
+                        p2.second.share());
+  EXPECT_GT(arena.used(), 0u);
+  p1.first.set_value(42);
+  EXPECT_FALSE(f.is_ready());
+  p2.first.set_value("qwe");
+  ASSERT_TRUE(f.is_ready());
+
+  auto res = f.get();
+  EXPECT_EQ(std::get<0>(res).get(), 42);
+  EXPECT_EQ(std::get<1>(res).get(), "qwe");
+}
+
 } // anonymous namespace
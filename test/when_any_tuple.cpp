@@ -3,6 +3,7 @@
 #include <portable_concurrency/future>
 #include <portable_concurrency/latch>
 
+#include "simple_arena_allocator.h"
 #include "test_tools.h"
 
 using namespace std::literals;
@@ -357,6 +358,22 @@ TEST_P(WhenAnyTupleTest, multiple_futures_one_initially_ready) {
   }
 }
 
+TEST(WhenAnyTupleTest, state_is_allocated_with_provided_allocator) {
+  static_arena<1024> arena;
+  arena_allocator<void, static_arena<1024>> alloc{arena};
+  auto p1 = pc::make_promise<int>();
+  auto p2 = pc::make_promise<std::string>();
+  auto f = pc::when_any(std::allocator_arg, alloc, std::move(p1.second),
+                        std::move(p2.second));
+  EXPECT_GT(arena.used(), 0u);
+  p2.first.set_value("qwe");
+  ASSERT_TRUE(f.is_ready());
+
+  auto res = f.get();
+  EXPECT_EQ(res.index, 1u);
+  EXPECT_EQ(std::get<1>(res.futures).get(), "qwe");
+}
+
 size_t first_idx_vals[] = {0, 1, 2, 3, 4};
 INSTANTIATE_TEST_CASE_P(AllVals, WhenAnyTupleTest,
                         ::testing::ValuesIn(first_idx_vals));